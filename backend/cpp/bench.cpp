@@ -0,0 +1,320 @@
+// End-to-End Benchmark for the Finance Engine
+// Data Structures & Applications Lab Project
+// Generates data at each size, then times startup and every command (p50/p99, throughput)
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "datagen.h"
+#include "bench_support.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#ifndef _WIN32
+// ===== COMMANDS =====
+
+struct BenchContext {
+    SplitMix64 rng;
+    long long endDay;
+    long long span;
+    std::vector<std::string> addedTransactions;    // ids the bench created
+    std::vector<std::string> addedBills;
+    std::vector<std::string> paidBills;
+    
+    BenchContext(uint64_t seed, long long end, long long days) : rng(seed), endDay(end), span(days) {}
+    
+    std::string randomDate() { return civilFromDays(endDay - static_cast<long long>(rng.below(span))); }
+    const char* randomCategory() { return GEN_EXPENSE_CATEGORIES[rng.below(GEN_EXPENSE_COUNT)].name; }
+    
+    std::string takeLast(std::vector<std::string>& ids) {
+        if (ids.empty()) return "none";
+        std::string id = ids.back();
+        ids.pop_back();
+        return id;
+    }
+};
+
+// "id" of the record an add_* command returned
+std::string responseId(const std::string& response) {
+    size_t at = response.find("\"id\":\"");
+    if (at == std::string::npos) return std::string();
+    at += 6;
+    return response.substr(at, response.find('"', at) - at);
+}
+
+struct BenchCommand {
+    const char* name;
+    bool scansHistory;      // O(n): fewer iterations at large sizes
+    std::string (*makeRequest)(BenchContext&);
+    void (*onResponse)(BenchContext&, const std::string&);
+};
+
+std::string params(const char* command, const std::string& fields) {
+    return std::string("{\"command\":\"") + command + "\",\"params\":{" + fields + "}}";
+}
+
+std::string jsonText(const std::string& s) {
+    return "\"" + s + "\"";
+}
+
+// Reads run on the generated data first, then writes (each one fsyncs its
+// log record, as in production). Every command of the engine's table.
+const BenchCommand BENCH_COMMANDS[] = {
+    {"get_dashboard", false, [](BenchContext&) { return params("get_dashboard", ""); }, nullptr},
+    {"get_transactions", true, [](BenchContext&) { return params("get_transactions", ""); }, nullptr},
+    {"get_transactions limit=100", false,
+     [](BenchContext&) { return params("get_transactions", "\"limit\":100"); }, nullptr},
+    {"get_recent_transactions", false,
+     [](BenchContext&) { return params("get_recent_transactions", "\"count\":10"); }, nullptr},
+    {"get_transactions_by_date 30d", false, [](BenchContext& c) {
+        long long start = c.endDay - static_cast<long long>(c.rng.below(c.span));
+        return params("get_transactions_by_date", "\"startDate\":" + jsonText(civilFromDays(start)) +
+                      ",\"endDate\":" + jsonText(civilFromDays(start + 30)));
+    }, nullptr},
+    {"get_budgets", false, [](BenchContext&) { return params("get_budgets", ""); }, nullptr},
+    {"get_alerts", false, [](BenchContext&) { return params("get_alerts", ""); }, nullptr},
+    {"get_bills", false, [](BenchContext&) { return params("get_bills", ""); }, nullptr},
+    {"get_top_expenses", true, [](BenchContext&) { return params("get_top_expenses", "\"count\":10"); }, nullptr},
+    {"get_top_categories", false,
+     [](BenchContext&) { return params("get_top_categories", "\"count\":5"); }, nullptr},
+    {"get_monthly_summary", true, [](BenchContext& c) {
+        return params("get_monthly_summary", "\"month\":" + jsonText(c.randomDate().substr(0, 7)));
+    }, nullptr},
+    {"get_category_suggestions", false, [](BenchContext& c) {
+        std::string category = c.randomCategory();
+        return params("get_category_suggestions",
+                      "\"prefix\":" + jsonText(category.substr(0, 1 + c.rng.below(2))));
+    }, nullptr},
+    {"get_all_categories", false, [](BenchContext&) { return params("get_all_categories", ""); }, nullptr},
+    {"get_metrics", false, [](BenchContext&) { return params("get_metrics", ""); }, nullptr},
+    {"get_engine_stats", false, [](BenchContext&) { return params("get_engine_stats", ""); }, nullptr},
+    {"add_transaction", false, [](BenchContext& c) {
+        return params("add_transaction", "\"type\":\"expense\",\"amount\":" +
+                      std::to_string(1 + c.rng.below(200)) + ",\"category\":" + jsonText(c.randomCategory()) +
+                      ",\"description\":\"Bench\",\"date\":" + jsonText(c.randomDate()));
+    }, [](BenchContext& c, const std::string& response) {
+        std::string id = responseId(response);
+        if (!id.empty()) c.addedTransactions.push_back(id);
+    }},
+    {"delete_transaction", false, [](BenchContext& c) {
+        return params("delete_transaction", "\"id\":" + jsonText(c.takeLast(c.addedTransactions)));
+    }, nullptr},
+    {"set_budget", false, [](BenchContext& c) {
+        return params("set_budget", "\"category\":" + jsonText(c.randomCategory()) +
+                      ",\"limit\":" + std::to_string(100 + c.rng.below(900)));
+    }, nullptr},
+    {"add_bill", false, [](BenchContext& c) {
+        return params("add_bill", "\"name\":\"Bench Bill\",\"amount\":" + std::to_string(10 + c.rng.below(90)) +
+                      ",\"dueDate\":" + jsonText(civilFromDays(c.endDay + 1 + c.rng.below(30))) +
+                      ",\"category\":" + jsonText(c.randomCategory()));
+    }, [](BenchContext& c, const std::string& response) {
+        std::string id = responseId(response);
+        if (!id.empty()) c.addedBills.push_back(id);
+    }},
+    {"pay_bill", false, [](BenchContext& c) {
+        std::string id = c.takeLast(c.addedBills);
+        c.paidBills.push_back(id);
+        return params("pay_bill", "\"id\":" + jsonText(id));
+    }, nullptr},
+    {"delete_bill", false, [](BenchContext& c) {
+        return params("delete_bill", "\"id\":" + jsonText(c.takeLast(c.paidBills)));
+    }, nullptr},
+    {"undo", false, [](BenchContext&) { return params("undo", ""); }, nullptr},
+    {"clear_undo", false, [](BenchContext&) { return params("clear_undo", ""); }, nullptr},
+    {"checkpoint", true, [](BenchContext&) { return params("checkpoint", ""); }, nullptr},
+};
+
+// ===== REPORT =====
+
+struct BenchResult {
+    size_t size;
+    std::string command;
+    size_t iterations;
+    double p50;             // microseconds
+    double p99;
+    double opsPerSecond;
+};
+
+BenchResult summarize(size_t size, const std::string& command, std::vector<double>& samples, double totalMicros) {
+    std::sort(samples.begin(), samples.end());
+    BenchResult r;
+    r.size = size;
+    r.command = command;
+    r.iterations = samples.size();
+    r.p50 = percentile(samples, 0.50);
+    r.p99 = percentile(samples, 0.99);
+    r.opsPerSecond = totalMicros > 0 ? samples.size() * 1e6 / totalMicros : 0;
+    return r;
+}
+
+void printResult(const BenchResult& r) {
+    std::cout << std::left << std::setw(10) << r.size << std::setw(34) << r.command << std::right
+              << std::setw(7) << r.iterations << std::fixed << std::setprecision(1)
+              << std::setw(13) << r.p50 << std::setw(13) << r.p99
+              << std::setw(12) << r.opsPerSecond << std::endl;
+}
+
+// ===== RUNS =====
+
+struct BenchOptions {
+    std::string engine;
+    std::vector<size_t> sizes;
+    size_t iterations;      // per command; history scans get fewer at large sizes
+    std::string workDir;
+    std::string csvPath;
+    std::vector<std::string> engineArgs;
+    DataGenOptions data;
+    
+    BenchOptions() : engine("./finance_engine"), iterations(200), workDir("bench_data") {}
+};
+
+// One-shot runs: spawn, load, answer one command, exit. The first run of a
+// fresh directory imports the JSON and writes a checkpoint.
+bool timeOneShot(const BenchOptions& options, const std::string& dataDir, const std::string& request,
+                 size_t runs, size_t size, const std::string& label, std::vector<BenchResult>& results) {
+    std::vector<double> samples;
+    double total = 0;
+    for (size_t i = 0; i < runs; i++) {
+        std::vector<std::string> args(1, dataDir);
+        args.insert(args.end(), options.engineArgs.begin(), options.engineArgs.end());
+        Clock::time_point start = Clock::now();
+        EngineProcess engine;
+        std::string response;
+        if (!engine.start(options.engine, args) || !engine.request(request, response)) return false;
+        engine.finish();
+        double micros = elapsedMicros(start);
+        samples.push_back(micros);
+        total += micros;
+    }
+    results.push_back(summarize(size, label, samples, total));
+    printResult(results.back());
+    return true;
+}
+
+bool benchSize(const BenchOptions& options, size_t size, std::vector<BenchResult>& results) {
+    std::string dataDir = options.workDir + "/n" + std::to_string(size);
+    DataGenOptions data = options.data;
+    data.transactions = size;
+    if (!ensureDirectory(options.workDir) || !ensureDirectory(dataDir) || !generateData(dataDir, data)) {
+        std::cerr << "Error: cannot generate data in " << dataDir << std::endl;
+        return false;
+    }
+    
+    // Startup: JSON import, then loads from the snapshots it wrote (all of
+    // them for get_dashboard, only bills for get_bills)
+    if (!timeOneShot(options, dataDir, params("get_bills", ""), 1, size, "startup: json import", results) ||
+        !timeOneShot(options, dataDir, params("get_dashboard", ""), 3, size, "startup: get_dashboard", results) ||
+        !timeOneShot(options, dataDir, params("get_bills", ""), 3, size, "startup: get_bills (lazy)", results)) {
+        std::cerr << "Error: engine failed on " << dataDir << std::endl;
+        return false;
+    }
+    
+    std::vector<std::string> args = {dataDir, "--serve"};
+    args.insert(args.end(), options.engineArgs.begin(), options.engineArgs.end());
+    EngineProcess engine;
+    if (!engine.start(options.engine, args)) return false;
+    
+    long long endDay = 0;
+    parseCivil(data.endDate, endDay);  // generateData checked it
+    BenchContext context(data.seed + size, endDay, std::max(1, data.years) * 365LL);
+    
+    for (const auto& command : BENCH_COMMANDS) {
+        size_t iterations = options.iterations;
+        if (command.scansHistory) {
+            iterations = std::max<size_t>(3, std::min(iterations, options.iterations * 1000 / size));
+        }
+        
+        std::vector<double> samples;
+        std::string response;
+        Clock::time_point begin = Clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            std::string request = command.makeRequest(context);
+            Clock::time_point start = Clock::now();
+            if (!engine.request(request, response)) {
+                std::cerr << "Error: engine stopped during " << command.name << std::endl;
+                return false;
+            }
+            samples.push_back(elapsedMicros(start));
+            if (command.onResponse) command.onResponse(context, response);
+        }
+        results.push_back(summarize(size, command.name, samples, elapsedMicros(begin)));
+        printResult(results.back());
+    }
+    return engine.finish() == 0;
+}
+
+bool writeCsv(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream csv(path);
+    if (!csv) return false;
+    csv << "size,command,iterations,p50_us,p99_us,ops_per_sec\n";
+    for (const auto& r : results) {
+        csv << r.size << ",\"" << r.command << "\"," << r.iterations << "," << r.p50 << ","
+            << r.p99 << "," << r.opsPerSecond << "\n";
+    }
+    return static_cast<bool>(csv);
+}
+
+int main(int argc, char* argv[]) {
+    // Parse arguments: [--engine PATH] [--sizes 1e3,1e5,...] [--iterations N]
+    // [--seed N] [--work DIR] [--csv FILE] [-- engine flags...]
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc) {
+            options.engine = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            const char* p = argv[++i];
+            while (*p) {
+                char* end;
+                double size = std::strtod(p, &end);
+                if (end == p) break;
+                if (size >= 1) options.sizes.push_back(static_cast<size_t>(size));
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            options.iterations = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.data.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--work" && i + 1 < argc) {
+            options.workDir = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--") {
+            options.engineArgs.assign(argv + i + 1, argv + argc);
+            break;
+        }
+    }
+    if (options.sizes.empty()) options.sizes = {1000, 10000, 100000};
+    
+    signal(SIGPIPE, SIG_IGN);   // a crashed engine shows up as a failed write
+    
+    std::cout << std::left << std::setw(10) << "size" << std::setw(34) << "command" << std::right
+              << std::setw(7) << "iters" << std::setw(13) << "p50 us" << std::setw(13) << "p99 us"
+              << std::setw(12) << "ops/s" << std::endl;
+    
+    std::vector<BenchResult> results;
+    for (size_t size : options.sizes) {
+        if (!benchSize(options, size, results)) return 1;
+    }
+    
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        std::cerr << "Error: cannot write " << options.csvPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#else
+int main() {
+    std::cerr << "finance_bench needs POSIX pipes and fork; it is not supported on this platform" << std::endl;
+    return 1;
+}
+#endif
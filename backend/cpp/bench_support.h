@@ -0,0 +1,179 @@
+// Shared Pieces of the Benchmark Tools
+// Data Structures & Applications Lab Project
+// Operations: run the engine as a child process, talk to it over pipes or its socket,
+//             time requests, percentiles
+
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cstring>
+#include <thread>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+inline double elapsedMicros(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+#ifndef _WIN32
+// ===== ENGINE CHANNELS =====
+// One request line out, one response line back: JSON in, JSON out, the way
+// the Python backend talks to the engine
+
+class LineChannel {
+protected:
+    int toEngine;
+    int fromEngine;         // the same descriptor as toEngine on a socket
+    std::string pending;    // read but not yet returned
+
+public:
+    LineChannel() : toEngine(-1), fromEngine(-1) {}
+    
+    LineChannel(const LineChannel&) = delete;
+    LineChannel& operator=(const LineChannel&) = delete;
+    
+    // Send one request line and read one response line
+    bool request(const std::string& line, std::string& response) {
+        std::string message = line + "\n";
+        size_t written = 0;
+        while (written < message.size()) {
+            ssize_t n = write(toEngine, message.data() + written, message.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            written += n;
+        }
+        return readLine(response);
+    }
+    
+    bool readLine(std::string& line) {
+        char buffer[65536];
+        size_t newline;
+        while ((newline = pending.find('\n')) == std::string::npos) {
+            ssize_t n = read(fromEngine, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            pending.append(buffer, n);
+        }
+        line.assign(pending, 0, newline);
+        pending.erase(0, newline + 1);
+        return true;
+    }
+};
+
+// The engine as a child process with pipes on stdin/stdout, so a benchmark
+// sees exactly what the Python backend sees
+class EngineProcess : public LineChannel {
+private:
+    pid_t pid;
+
+public:
+    EngineProcess() : pid(-1) {}
+    ~EngineProcess() { finish(); }
+    
+    bool start(const std::string& engine, const std::vector<std::string>& args) {
+        int in[2], out[2];
+        if (pipe(in) != 0) return false;
+        if (pipe(out) != 0) {
+            close(in[0]);
+            close(in[1]);
+            return false;
+        }
+        
+        pid = fork();
+        if (pid == 0) {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            close(in[0]);
+            close(in[1]);
+            close(out[0]);
+            close(out[1]);
+            
+            std::vector<char*> argv;
+            argv.push_back(const_cast<char*>(engine.c_str()));
+            for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+            argv.push_back(nullptr);
+            execv(engine.c_str(), argv.data());
+            _exit(127);
+        }
+        
+        close(in[0]);
+        close(out[1]);
+        toEngine = in[1];
+        fromEngine = out[0];
+        return pid > 0;
+    }
+    
+    // Close stdin (a resident engine exits on EOF) and reap the child
+    int finish() {
+        if (toEngine >= 0) close(toEngine);
+        if (fromEngine >= 0) close(fromEngine);
+        toEngine = fromEngine = -1;
+        int status = 0;
+        if (pid > 0) waitpid(pid, &status, 0);
+        pid = -1;
+        return status;
+    }
+    
+    // For an engine that does not read stdin (--socket): ask it to exit
+    int stop() {
+        if (pid > 0) kill(pid, SIGTERM);
+        return finish();
+    }
+};
+
+// A client connection to an engine serving --socket PATH
+class EngineConnection : public LineChannel {
+public:
+    ~EngineConnection() { close(); }
+    
+    // The engine may still be starting: retry until it listens or the timeout passes
+    bool connect(const std::string& socketPath, int timeoutMs) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+        std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) return false;
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                toEngine = fromEngine = fd;
+                return true;
+            }
+            ::close(fd);
+            if (Clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    
+    void close() {
+        if (toEngine >= 0) ::close(toEngine);
+        toEngine = fromEngine = -1;
+        pending.clear();
+    }
+};
+#endif
+
+// Nearest-rank percentile of sorted samples
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+#endif // BENCH_SUPPORT_H
@@ -1,21 +1,33 @@
 // Binary Search Tree Implementation for Date-wise Transaction Storage
 // Data Structures & Applications Lab Project
-// Operations: insert, in-order traversal, range query
+// Operations: insert (AVL-balanced), in-order traversal, range query, bounded visits
 
 #ifndef BST_H
 #define BST_H
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "linkedlist.h"
 
+// Shape and footprint of the date index (see BST::stats)
+struct BSTStats {
+    int nodes;          // distinct dates
+    int transactions;
+    int height;         // nodes on the longest root-to-leaf path
+    size_t bytes;
+    
+    BSTStats() : nodes(0), transactions(0), height(0), bytes(0) {}
+};
+
 struct BSTNode {
     std::string date;  // Format: YYYY-MM-DD for proper string comparison
     std::vector<Transaction> transactions;  // Multiple transactions per date
     BSTNode* left;
     BSTNode* right;
+    int height;        // Nodes on the longest path down from here (AVL balance)
     
-    BSTNode(const std::string& d) : date(d), left(nullptr), right(nullptr) {}
+    BSTNode(const std::string& d) : date(d), left(nullptr), right(nullptr), height(1) {}
 };
 
 class BST {
@@ -23,7 +35,58 @@ private:
     BSTNode* root;
     int count;
     
-    // Helper: Insert recursively
+    // ===== AVL BALANCING =====
+    // Real data arrives in date order, which would degrade a plain BST into
+    // a list. Subtree heights on either side of a node differ by at most one,
+    // so the height stays O(log dates). Nodes are never removed (a date whose
+    // transactions are all deleted keeps an empty node), so only insert
+    // rebalances.
+    
+    static int heightOf(const BSTNode* node) { return node ? node->height : 0; }
+    
+    static void updateHeight(BSTNode* node) {
+        node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+    }
+    
+    static BSTNode* rotateRight(BSTNode* node) {
+        BSTNode* pivot = node->left;
+        node->left = pivot->right;
+        pivot->right = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+    
+    static BSTNode* rotateLeft(BSTNode* node) {
+        BSTNode* pivot = node->right;
+        node->right = pivot->left;
+        pivot->left = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+    
+    // Restore the AVL property at node after one of its subtrees grew by one
+    // Time Complexity: O(1)
+    static BSTNode* rebalance(BSTNode* node) {
+        updateHeight(node);
+        int balance = heightOf(node->left) - heightOf(node->right);
+        if (balance > 1) {
+            if (heightOf(node->left->left) < heightOf(node->left->right)) {
+                node->left = rotateLeft(node->left);
+            }
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            if (heightOf(node->right->right) < heightOf(node->right->left)) {
+                node->right = rotateRight(node->right);
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+    
+    // Helper: Insert recursively, rebalancing on the way back up
     BSTNode* insertHelper(BSTNode* node, const std::string& date, const Transaction& t) {
         if (!node) {
             BSTNode* newNode = new BSTNode(date);
@@ -38,9 +101,10 @@ private:
         } else {
             // Same date, add transaction to existing node
             node->transactions.push_back(t);
+            return node;
         }
         
-        return node;
+        return rebalance(node);
     }
     
     // Helper: In-order traversal
@@ -88,6 +152,28 @@ private:
         }
     }
     
+    // Helper: Visit date nodes within [lower, upper] (nullptr = unbounded) in
+    // date order; returns false once visit asks to stop
+    template<typename F>
+    bool visitHelper(BSTNode* node, const std::string* lower, const std::string* upper,
+                     bool descending, F& visit) const {
+        if (!node) return true;
+        
+        bool leftMayMatch = !lower || node->date > *lower;
+        bool rightMayMatch = !upper || node->date < *upper;
+        bool inRange = (!lower || node->date >= *lower) && (!upper || node->date <= *upper);
+        
+        BSTNode* first = descending ? node->right : node->left;
+        BSTNode* second = descending ? node->left : node->right;
+        bool firstMayMatch = descending ? rightMayMatch : leftMayMatch;
+        bool secondMayMatch = descending ? leftMayMatch : rightMayMatch;
+        
+        if (firstMayMatch && !visitHelper(first, lower, upper, descending, visit)) return false;
+        if (inRange && !node->transactions.empty() && !visit(node->date, node->transactions)) return false;
+        if (secondMayMatch && !visitHelper(second, lower, upper, descending, visit)) return false;
+        return true;
+    }
+    
     // Helper: Delete transaction by ID
     bool deleteTransactionHelper(BSTNode* node, const std::string& id) {
         if (!node) return false;
@@ -106,6 +192,17 @@ private:
         return deleteTransactionHelper(node->right, id);
     }
     
+    // Helper: Copy a subtree
+    BSTNode* copyHelper(const BSTNode* node) const {
+        if (!node) return nullptr;
+        BSTNode* copy = new BSTNode(node->date);
+        copy->transactions = node->transactions;
+        copy->height = node->height;
+        copy->left = copyHelper(node->left);
+        copy->right = copyHelper(node->right);
+        return copy;
+    }
+    
     // Helper: Clear tree
     void clearHelper(BSTNode* node) {
         if (!node) return;
@@ -114,6 +211,20 @@ private:
         delete node;
     }
     
+    // Helper: Accumulate node count, depth and footprint
+    void statsHelper(const BSTNode* node, int depth, BSTStats& s) const {
+        if (!node) return;
+        s.nodes++;
+        s.height = std::max(s.height, depth);
+        s.bytes += sizeof(BSTNode) + stringHeapBytes(node->date) +
+                   node->transactions.capacity() * sizeof(Transaction);
+        for (const auto& t : node->transactions) {
+            s.bytes += transactionHeapBytes(t);
+        }
+        statsHelper(node->left, depth + 1, s);
+        statsHelper(node->right, depth + 1, s);
+    }
+    
     // Helper: Find transaction by ID
     bool findHelper(BSTNode* node, const std::string& id, Transaction& result) const {
         if (!node) return false;
@@ -132,12 +243,18 @@ private:
 public:
     BST() : root(nullptr), count(0) {}
     
+    // Deep copy, same shape
+    // Time Complexity: O(n)
+    BST(const BST& other) : root(copyHelper(other.root)), count(other.count) {}
+    
+    BST& operator=(const BST&) = delete;
+    
     ~BST() {
         clearHelper(root);
     }
     
     // Insert transaction sorted by date
-    // Time Complexity: O(log n) average, O(n) worst case
+    // Time Complexity: O(log d), d = distinct dates
     void insert(const Transaction& t) {
         root = insertHelper(root, t.date, t);
         count++;
@@ -160,13 +277,21 @@ public:
     }
     
     // Range query: Get transactions between two dates
-    // Time Complexity: O(log n + k) where k is number of results
+    // Time Complexity: O(log d + k) where k is number of results
     std::vector<Transaction> rangeQuery(const std::string& startDate, const std::string& endDate) const {
         std::vector<Transaction> result;
         rangeQueryHelper(root, startDate, endDate, result);
         return result;
     }
     
+    // Visit each date's transactions within [lower, upper] (nullptr = unbounded),
+    // ascending or descending, until visit(date, transactions) returns false
+    // Time Complexity: O(log d + dates visited)
+    template<typename F>
+    void visitRange(const std::string* lower, const std::string* upper, bool descending, F visit) const {
+        visitHelper(root, lower, upper, descending, visit);
+    }
+    
     // Delete transaction by ID
     // Time Complexity: O(n)
     bool deleteById(const std::string& id) {
@@ -188,6 +313,15 @@ public:
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
     
+    // Height, node count and footprint
+    // Time Complexity: O(nodes + n)
+    BSTStats stats() const {
+        BSTStats s;
+        statsHelper(root, 1, s);
+        s.transactions = count;
+        return s;
+    }
+    
     void clear() {
         clearHelper(root);
         root = nullptr;
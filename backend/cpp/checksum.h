@@ -0,0 +1,99 @@
+// CRC-32C (Castagnoli) Checksum for Persisted Engine Files
+// Data Structures & Applications Lab Project
+// SSE4.2 crc32 instruction 8 bytes per step, table-driven fallback
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHECKSUM_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef CHECKSUM_X86
+// The crc32 instruction computes exactly CRC-32C; three cycles of latency per
+// 8 bytes against eight dependent table lookups, so verifying a snapshot
+// costs a small fraction of parsing it
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cHardware(uint32_t crc, const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t c = ~crc;
+#ifdef __x86_64__
+    uint64_t wide = c;
+    for (; length >= 8; p += 8, length -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    c = static_cast<uint32_t>(wide);
+#endif
+    for (; length >= 4; p += 4, length -= 4) {
+        uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u32(c, word);
+    }
+    for (; length > 0; p++, length--) {
+        c = _mm_crc32_u8(c, *p);
+    }
+    return ~c;
+}
+#endif
+
+class Crc32c {
+private:
+    uint32_t table[256];
+    bool hardware;
+    
+    Crc32c() : hardware(false) {
+        // Reflected polynomial 0x1EDC6F41
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : (crc >> 1);
+            }
+            table[i] = crc;
+        }
+        
+        // FINANCE_CRC=table keeps the fallback, e.g. for comparisons
+#ifdef CHECKSUM_X86
+        __builtin_cpu_init();
+        hardware = __builtin_cpu_supports("sse4.2");
+#endif
+        const char* forced = std::getenv("FINANCE_CRC");
+        if (forced && std::strcmp(forced, "table") == 0) hardware = false;
+    }
+    
+public:
+    static const Crc32c& instance() {
+        static const Crc32c crc;
+        return crc;
+    }
+    
+    // Continue a running checksum over more bytes
+    // Time Complexity: O(n)
+    uint32_t update(uint32_t crc, const void* data, size_t length) const {
+#ifdef CHECKSUM_X86
+        if (hardware) return crc32cHardware(crc, data, length);
+#endif
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+    
+    const char* name() const { return hardware ? "sse4.2" : "table"; }
+};
+
+// Checksum of a whole buffer
+inline uint32_t crc32c(const void* data, size_t length) {
+    return Crc32c::instance().update(0, data, length);
+}
+
+#endif // CHECKSUM_H
@@ -0,0 +1,49 @@
+// Synthetic Data Generator for the Finance Engine
+// Data Structures & Applications Lab Project
+// Writes deterministic transactions/budgets/bills JSON files at a chosen scale
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "datagen.h"
+
+const char* USAGE = "usage: finance_datagen <dataDir> [--count N] [--seed N] [--end YYYY-MM-DD] [--years N]";
+
+int main(int argc, char* argv[]) {
+    // Parse arguments: <dataDir> [--count N] [--seed N] [--end YYYY-MM-DD] [--years N]
+    // (N may be written as 1e6). Anything else that looks like an option
+    // (including --help) prints the usage rather than becoming the data directory.
+    DataGenOptions options;
+    std::string dataDir;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--count" && i + 1 < argc) {
+            options.transactions = static_cast<size_t>(std::strtod(argv[++i], nullptr));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--end" && i + 1 < argc) {
+            options.endDate = argv[++i];
+        } else if (arg == "--years" && i + 1 < argc) {
+            options.years = std::atoi(argv[++i]);
+        } else if (arg[0] == '-' || !dataDir.empty()) {
+            std::cerr << "Unexpected argument " << arg << "\n" << USAGE << std::endl;
+            return 1;
+        } else {
+            dataDir = arg;
+        }
+    }
+    
+    if (dataDir.empty()) {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+    if (!ensureDirectory(dataDir) || !generateData(dataDir, options)) {
+        std::cerr << "Error: cannot generate data in " << dataDir << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Wrote " << options.transactions << " transactions, " << GEN_EXPENSE_COUNT
+              << " budgets and " << generatedBillCount(options.transactions) << " bills to "
+              << dataDir << std::endl;
+    return 0;
+}
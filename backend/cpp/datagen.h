@@ -0,0 +1,257 @@
+// Deterministic Synthetic Data Generator for Benchmarks
+// Data Structures & Applications Lab Project
+// Operations: seeded PRNG, Zipf category skew, recency-skewed dates, write the JSON data files
+
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "json_writer.h"
+#include "fileutil.h"
+
+// splitmix64: tiny, fast and the same on every platform and compiler (the
+// <random> distributions are not), so a seed always yields the same files
+class SplitMix64 {
+private:
+    uint64_t state;
+
+public:
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+    
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+    // Uniform in [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n) { return static_cast<uint64_t>(uniform() * n); }
+    
+    // Standard normal (Box-Muller)
+    double normal() {
+        double u = 1.0 - uniform();
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * uniform());
+    }
+};
+
+// Samples ranks 0..n-1 with P(k) proportional to 1 / (k+1)^s, so the first
+// few categories get most of the records, as in real ledgers
+class ZipfSampler {
+private:
+    std::vector<double> cumulative;
+
+public:
+    ZipfSampler(size_t n, double s) : cumulative(n) {
+        double total = 0;
+        for (size_t k = 0; k < n; k++) {
+            total += 1.0 / std::pow(static_cast<double>(k + 1), s);
+            cumulative[k] = total;
+        }
+        for (auto& c : cumulative) c /= total;
+    }
+    
+    // Time Complexity: O(log n)
+    size_t sample(SplitMix64& rng) const {
+        double u = rng.uniform();
+        size_t lo = 0, hi = cumulative.size() - 1;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cumulative[mid] < u) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+};
+
+// ===== CALENDAR =====
+// Days since 1970-01-01 <-> civil dates (proleptic Gregorian)
+
+inline long long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+inline std::string civilFromDays(long long z) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    int y = static_cast<int>(yoe + era * 400 + (m <= 2));
+    
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", y, m, d);
+    return buffer;
+}
+
+// Parse YYYY-MM-DD into days since the epoch; false if malformed
+inline bool parseCivil(const std::string& date, long long& days) {
+    int y, m, d;
+    if (std::sscanf(date.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        return false;
+    }
+    days = daysFromCivil(y, m, d);
+    return true;
+}
+
+// ===== GENERATOR =====
+
+struct DataGenOptions {
+    size_t transactions;
+    uint64_t seed;
+    std::string endDate;    // newest transaction date
+    int years;              // history span ending at endDate
+    
+    DataGenOptions() : transactions(1000), seed(42), endDate("2025-12-31"), years(3) {}
+};
+
+struct GenCategory {
+    const char* name;
+    double median;          // typical amount
+    const char* payees[4];
+};
+
+// Expense categories in Zipf rank order (most frequent first)
+const GenCategory GEN_EXPENSE_CATEGORIES[] = {
+    {"Food",          18.0, {"Corner Cafe", "Pizza Place", "Lunch Spot", "Food Court"}},
+    {"Groceries",     62.0, {"FreshMart", "Green Grocer", "Bulk Barn", "Farmers Market"}},
+    {"Transport",     14.0, {"Metro Card", "Ride Share", "Fuel Station", "Parking"}},
+    {"Shopping",      45.0, {"Online Store", "Mall Outlet", "Bookshop", "Electronics Hub"}},
+    {"Entertainment", 25.0, {"Cinema", "Streaming", "Concert Hall", "Game Store"}},
+    {"Utilities",     85.0, {"Power Co", "Water Board", "Internet Provider", "Phone Plan"}},
+    {"Health",        40.0, {"Pharmacy", "Clinic", "Dental Care", "Gym Membership"}},
+    {"Rent",        1200.0, {"Landlord", "Property Manager", "Housing Co-op", "Lease Office"}},
+    {"Education",    120.0, {"Course Fees", "Textbooks", "Workshop", "Tuition"}},
+    {"Travel",       310.0, {"Airline", "Hotel", "Train Tickets", "Travel Agency"}},
+    {"Insurance",    150.0, {"Auto Insurance", "Health Plan", "Home Insurance", "Life Policy"}},
+    {"Gifts",         35.0, {"Gift Shop", "Florist", "Charity", "Card Store"}},
+};
+
+const GenCategory GEN_INCOME_CATEGORIES[] = {
+    {"Salary",      3200.0, {"Employer Payroll", "Monthly Salary", "Bonus", "Payroll"}},
+    {"Freelance",    450.0, {"Client Project", "Consulting", "Design Gig", "Contract Work"}},
+    {"Investment",   120.0, {"Dividends", "Interest", "Fund Payout", "Stock Sale"}},
+};
+
+const size_t GEN_EXPENSE_COUNT = sizeof(GEN_EXPENSE_CATEGORIES) / sizeof(GEN_EXPENSE_CATEGORIES[0]);
+const size_t GEN_INCOME_COUNT = sizeof(GEN_INCOME_CATEGORIES) / sizeof(GEN_INCOME_CATEGORIES[0]);
+
+// Bills scale with the history but stay a queue a person could have
+inline size_t generatedBillCount(size_t transactions) {
+    return std::max<size_t>(10, std::min<size_t>(transactions / 100, 100000));
+}
+
+// Amount around a median: log-normal, rounded to cents
+inline double generateAmount(SplitMix64& rng, double median) {
+    double amount = median * std::exp(0.6 * rng.normal());
+    return std::max(0.01, std::round(amount * 100) / 100);
+}
+
+// Open path.tmp, stream {"<key>":[...]} through writeItem(writer, i) and
+// rename it into place
+template<typename F>
+bool writeGeneratedFile(const std::string& path, const char* key, size_t count, F writeItem) {
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    
+    JsonWriter out;
+    out.setSink(file);
+    out.raw("{\"").raw(key).raw("\":[");
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; i++) {
+        out.separator(i);
+        writeItem(out, i);
+        ok = out.drain();
+    }
+    out.raw("]}");
+    ok = out.flushTo(file) && ok;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return replaceFile(tmpPath, path);
+}
+
+// Write transactions.json, budgets.json, bills.json and an empty
+// undo_stack.json into dataDir. Categories follow a Zipf law (s = 1.1),
+// ~10% of records are income, and dates crowd towards endDate (the age in
+// days is span * u^2), like a ledger that is used more over time.
+// Time Complexity: O(n log c) for n transactions over c categories
+inline bool generateData(const std::string& dataDir, const DataGenOptions& options) {
+    long long endDay;
+    if (!parseCivil(options.endDate, endDay)) return false;
+    long long span = std::max(1, options.years) * 365LL;
+    
+    SplitMix64 rng(options.seed);
+    ZipfSampler expenseRank(GEN_EXPENSE_COUNT, 1.1);
+    ZipfSampler incomeRank(GEN_INCOME_COUNT, 1.1);
+    
+    std::vector<double> monthlySpend(GEN_EXPENSE_COUNT, 0);
+    bool ok = writeGeneratedFile(dataDir + "/transactions.json", "transactions", options.transactions,
+                                 [&](JsonWriter& w, size_t i) {
+        bool income = rng.below(10) == 0;
+        size_t rank = income ? incomeRank.sample(rng) : expenseRank.sample(rng);
+        const GenCategory& category = income ? GEN_INCOME_CATEGORIES[rank] : GEN_EXPENSE_CATEGORIES[rank];
+        double amount = generateAmount(rng, category.median);
+        double u = rng.uniform();
+        long long day = endDay - static_cast<long long>(span * u * u);
+        if (!income) monthlySpend[rank] += amount;
+        
+        w.raw("{\"id\":\"txn_gen_").integer(static_cast<long long>(i)).raw('"')
+         .raw(",\"type\":").string(income ? "income" : "expense")
+         .raw(",\"amount\":").number(amount)
+         .raw(",\"category\":").string(category.name)
+         .raw(",\"description\":").string(category.payees[rng.below(4)])
+         .raw(",\"date\":").string(civilFromDays(day)).raw('}');
+    });
+    
+    // A budget per expense category at ~120% of its average month
+    double months = span / 30.0;
+    ok = ok && writeGeneratedFile(dataDir + "/budgets.json", "budgets", GEN_EXPENSE_COUNT,
+                                  [&](JsonWriter& w, size_t i) {
+        double limit = std::max(50.0, std::round(monthlySpend[i] / months * 1.2));
+        w.raw("{\"category\":").string(GEN_EXPENSE_CATEGORIES[i].name)
+         .raw(",\"limit\":").number(limit).raw('}');
+    });
+    
+    // Bills due within two months either side of endDate; most past ones paid
+    ok = ok && writeGeneratedFile(dataDir + "/bills.json", "bills", generatedBillCount(options.transactions),
+                                  [&](JsonWriter& w, size_t i) {
+        const GenCategory& category = GEN_EXPENSE_CATEGORIES[5 + rng.below(GEN_EXPENSE_COUNT - 5)];
+        long long offset = static_cast<long long>(rng.below(120)) - 60;
+        bool paid = offset < 0 && rng.below(10) < 7;
+        w.raw("{\"id\":\"bill_gen_").integer(static_cast<long long>(i)).raw('"')
+         .raw(",\"name\":").string(category.payees[rng.below(4)])
+         .raw(",\"amount\":").number(generateAmount(rng, category.median))
+         .raw(",\"dueDate\":").string(civilFromDays(endDay + offset))
+         .raw(",\"category\":").string(category.name)
+         .raw(",\"isPaid\":").raw(paid ? "true" : "false").raw('}');
+    });
+    
+    ok = ok && writeGeneratedFile(dataDir + "/undo_stack.json", "actions", 0, [](JsonWriter&, size_t) {});
+    
+    // Without a checkpoint the engine imports the new files on its next start
+    std::remove((dataDir + "/snapshot.manifest").c_str());
+    std::remove((dataDir + "/engine.wal").c_str());
+    return ok;
+}
+
+#endif // DATAGEN_H
@@ -0,0 +1,137 @@
+// Epoch-Based Reclamation for Versions Shared with Concurrent Readers
+// Data Structures & Applications Lab Project
+// Operations: enter/exit a read epoch, retire an object, reclaim what no reader can see,
+//             unpublish an object for reuse
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// A reader announces the global epoch in a slot before it loads a shared
+// pointer; a writer that unpublishes an object retires it with the epoch
+// current at that moment. An object is freed once every active reader
+// announced a later epoch, since such readers loaded the pointer after it
+// was replaced. Readers only touch their slot: no lock, no shared counter.
+class EpochManager {
+private:
+    static const int SLOT_COUNT = 256;
+    static const uint64_t IDLE = 0;
+    
+    struct Retired {
+        uint64_t epoch;
+        void* object;
+        void (*destroy)(void*);
+    };
+    
+    std::atomic<uint64_t> globalEpoch;
+    std::atomic<uint64_t> slots[SLOT_COUNT];
+    
+    std::mutex retireMutex;
+    std::vector<Retired> retired;
+    
+    // Oldest epoch an active reader may still be in
+    uint64_t oldestActive() const {
+        uint64_t oldest = UINT64_MAX;
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            uint64_t epoch = slots[i].load();
+            if (epoch != IDLE && epoch < oldest) oldest = epoch;
+        }
+        return oldest;
+    }
+    
+    // Free every retired object no reader can hold; caller holds retireMutex
+    void reclaimLocked() {
+        uint64_t oldest = oldestActive();
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); i++) {
+            if (retired[i].epoch < oldest) {
+                retired[i].destroy(retired[i].object);
+            } else {
+                retired[kept++] = retired[i];
+            }
+        }
+        retired.resize(kept);
+    }
+
+public:
+    EpochManager() : globalEpoch(1) {
+        for (int i = 0; i < SLOT_COUNT; i++) slots[i].store(IDLE);
+    }
+    
+    ~EpochManager() {
+        for (const auto& r : retired) r.destroy(r.object);
+    }
+    
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+    
+    // Announce a read; returns the slot to pass to exit(). Spins only if
+    // more than SLOT_COUNT readers are active at once.
+    // Time Complexity: O(1) typical
+    int enter() {
+        thread_local int hint = 0;
+        while (true) {
+            for (int n = 0; n < SLOT_COUNT; n++) {
+                int i = (hint + n) % SLOT_COUNT;
+                uint64_t expected = IDLE;
+                if (slots[i].compare_exchange_strong(expected, globalEpoch.load())) {
+                    hint = i;
+                    return i;
+                }
+            }
+        }
+    }
+    
+    void exit(int slot) {
+        slots[slot].store(IDLE);
+    }
+    
+    // Hand over an object that was just unpublished; it is deleted once no
+    // reader that could have loaded it remains
+    template<typename T>
+    void retire(T* object) {
+        std::lock_guard<std::mutex> guard(retireMutex);
+        retired.push_back(Retired{globalEpoch.fetch_add(1), object,
+                                  [](void* p) { delete static_cast<T*>(p); }});
+        reclaimLocked();
+    }
+    
+    // Unpublish an object the caller keeps for reuse instead of retiring it;
+    // pass the returned epoch to isQuiescent() before changing the object
+    uint64_t unpublish() {
+        return globalEpoch.fetch_add(1);
+    }
+    
+    // No reader that could have loaded an object unpublished at this epoch
+    // is still active
+    // Time Complexity: O(SLOT_COUNT)
+    bool isQuiescent(uint64_t epoch) const {
+        return epoch < oldestActive();
+    }
+    
+    // Free what can be freed now (e.g. after readers finished)
+    void reclaim() {
+        std::lock_guard<std::mutex> guard(retireMutex);
+        if (!retired.empty()) reclaimLocked();
+    }
+};
+
+// Keeps the calling thread inside a read epoch for its lifetime
+class EpochGuard {
+private:
+    EpochManager& manager;
+    int slot;
+
+public:
+    explicit EpochGuard(EpochManager& m) : manager(m), slot(m.enter()) {}
+    ~EpochGuard() { manager.exit(slot); }
+    
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif // EPOCH_H
@@ -0,0 +1,127 @@
+// File Helpers for Durable Persistence
+// Data Structures & Applications Lab Project
+// Operations: fsync a stream or directory, truncate in place, atomic replace, whole-file read,
+//             create a directory, test for one
+
+#ifndef FILEUTIL_H
+#define FILEUTIL_H
+
+#include <string>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <direct.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+// Flush a stdio stream all the way to the disk
+inline bool syncFile(FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Cut a stream's file to length bytes in place and make that durable; the
+// bytes before length are never rewritten
+inline bool truncateFile(FILE* file, size_t length) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    if (_chsize_s(_fileno(file), static_cast<long long>(length)) != 0) return false;
+#else
+    if (ftruncate(fileno(file), static_cast<off_t>(length)) != 0) return false;
+#endif
+    return syncFile(file);
+}
+
+// Make the entries of the directory holding path (a rename into it)
+// durable; a no-op where directories cannot be synced
+inline bool syncParentDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+// Move a finished, synced temporary over path, then sync the directory so
+// the rename itself survives a crash
+inline bool replaceFile(const std::string& tmpPath, const std::string& path) {
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return syncParentDirectory(path);
+}
+
+// Write a file via a temporary and rename it into place, so readers see
+// either the old or the new contents, never a truncated mix
+inline bool writeFileAtomic(const std::string& path, const std::string& data) {
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = syncFile(file) && ok;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return replaceFile(tmpPath, path);
+}
+
+// Read a whole file into memory; returns false if it cannot be opened
+inline bool readFile(const std::string& path, std::string& data) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    
+    data.clear();
+    char chunk[65536];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.append(chunk, n);
+    }
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+// Create a directory (one level) unless it already exists
+inline bool ensureDirectory(const std::string& path) {
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+inline bool directoryExists(const std::string& path) {
+#ifdef _WIN32
+    struct _stat info;
+    return _stat(path.c_str(), &info) == 0 && (info.st_mode & _S_IFDIR);
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+#endif // FILEUTIL_H
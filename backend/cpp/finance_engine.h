@@ -12,12 +12,46 @@
 #include "queue.h"
 #include "stack.h"
 #include "trie.h"
+#include "metrics.h"
+#include "trace.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 
+// ===== INSTRUMENTATION =====
+// Data-structure operations timed inside the engine's public methods (bulk
+// loading is timed as a whole by the load phase instead). The methods also
+// open a trace span each, recorded only when tracing is on (see trace.h).
+enum StructureOp {
+    OP_LIST_INSERT, OP_LIST_DELETE, OP_LIST_SCAN,
+    OP_BST_INSERT, OP_BST_DELETE, OP_BST_FIND, OP_BST_RANGE, OP_BST_TRAVERSE,
+    OP_HASHMAP_UPDATE, OP_HASHMAP_SCAN,
+    OP_HEAP_TOPK,
+    OP_TRIE_INSERT, OP_TRIE_PREFIX,
+    OP_QUEUE_ENQUEUE, OP_QUEUE_SCAN,
+    OP_UNDO_PUSH,
+    STRUCTURE_OP_COUNT
+};
+
+const char* const STRUCTURE_OP_NAMES[STRUCTURE_OP_COUNT] = {
+    "list.insert", "list.delete", "list.scan",
+    "bst.insert", "bst.delete", "bst.find", "bst.range", "bst.traverse",
+    "hashmap.update", "hashmap.scan",
+    "heap.topk",
+    "trie.insert", "trie.prefix",
+    "queue.enqueue", "queue.scan",
+    "undo.push",
+};
+
+// One histogram per operation, shared by every engine in the process
+inline LatencyHistogram& structureHistogram(StructureOp op) {
+    static LatencyHistogram histograms[STRUCTURE_OP_COUNT];
+    return histograms[op];
+}
+
 // Budget structure
 struct Budget {
     std::string category;
@@ -54,6 +88,85 @@ struct MonthlySummary {
     MonthlySummary() : totalIncome(0), totalExpenses(0), netSavings(0), transactionCount(0) {}
 };
 
+// Mutation kinds recorded for the write-ahead log
+enum MutationType {
+    MUT_ADD_TRANSACTION = 1,
+    MUT_DELETE_TRANSACTION = 2,
+    MUT_SET_BUDGET = 3,
+    MUT_ADD_BILL = 4,
+    MUT_PAY_BILL = 5,
+    MUT_DELETE_BILL = 6,
+    MUT_UNDO = 7,
+    MUT_CLEAR_UNDO = 8
+};
+
+// Collections persisted separately; expense totals travel with budgets
+enum Collection {
+    COLL_TRANSACTIONS = 0,
+    COLL_BUDGETS = 1,
+    COLL_BILLS = 2,
+    COLL_UNDO = 3
+};
+
+const int COLLECTION_COUNT = 4;
+
+// Sets of collections, one bit per Collection
+const unsigned MASK_TRANSACTIONS = 1u << COLL_TRANSACTIONS;
+const unsigned MASK_BUDGETS = 1u << COLL_BUDGETS;
+const unsigned MASK_BILLS = 1u << COLL_BILLS;
+const unsigned MASK_UNDO = 1u << COLL_UNDO;
+const unsigned MASK_ALL = (1u << COLLECTION_COUNT) - 1;
+
+// One state change, with everything needed to apply it again on replay
+struct Mutation {
+    MutationType type;
+    Transaction transaction;    // MUT_ADD_TRANSACTION
+    Bill bill;                  // MUT_ADD_BILL
+    std::string key;            // transaction/bill id, or budget category
+    double value;               // budget limit
+    
+    Mutation() : type(MUT_UNDO), value(0.0) {}
+    Mutation(MutationType t) : type(t), value(0.0) {}
+};
+
+// Collections a logged mutation reads or changes. An undo can revert
+// anything, so it needs them all.
+inline unsigned mutationCollections(MutationType type) {
+    switch (type) {
+        case MUT_ADD_TRANSACTION:
+        case MUT_DELETE_TRANSACTION:
+            return MASK_TRANSACTIONS | MASK_BUDGETS | MASK_UNDO;
+        case MUT_SET_BUDGET:
+            return MASK_BUDGETS | MASK_UNDO;
+        case MUT_ADD_BILL:
+        case MUT_PAY_BILL:
+        case MUT_DELETE_BILL:
+            return MASK_BILLS | MASK_UNDO;
+        case MUT_CLEAR_UNDO:
+            return MASK_UNDO;
+        default:
+            return MASK_ALL;
+    }
+}
+
+// Keyset position after the last transaction of a page
+struct PageCursor {
+    std::string date;
+    std::string id;         // Last transaction returned
+    size_t offset;          // Its index within the date + 1 (used if it was deleted since)
+    
+    PageCursor() : offset(0) {}
+    bool isSet() const { return !date.empty(); }
+};
+
+struct TransactionPage {
+    std::vector<Transaction> transactions;
+    bool hasMore;
+    PageCursor next;        // Set when hasMore
+    
+    TransactionPage() : hasMore(false) {}
+};
+
 // Budget alert structure
 struct BudgetAlert {
     std::string category;
@@ -64,6 +177,31 @@ struct BudgetAlert {
     std::string message;
 };
 
+// Internals of every structure, for spotting one that degrades before it
+// shows in latency (see getEngineStats)
+struct EngineStats {
+    HashMapStats budgets;
+    HashMapStats expenseTotals;
+    ContainerStats transactionList;
+    BSTStats dateIndex;
+    ContainerStats billQueue;
+    ContainerStats undoStack;
+    ContainerStats recentStack;
+    TrieStats categories;
+    TrieStats payees;
+    int expenseHeapSize;        // what get_top_expenses builds its heap from
+    int categoryHeapSize;       // what get_top_categories builds its heap from
+    size_t totalBytes;
+    std::vector<std::string> warnings;
+    
+    EngineStats() : expenseHeapSize(0), categoryHeapSize(0), totalBytes(0) {}
+};
+
+// Thresholds for EngineStats::warnings
+const double STATS_MAX_MEAN_PROBE = 4.0;    // hash chain compares per lookup
+const int STATS_MAX_HEIGHT_FACTOR = 4;      // BST height over a balanced tree's
+const int STATS_MIN_DEAD_TRIE_NODES = 256;  // and over half of all trie nodes
+
 class FinanceEngine {
 private:
     // Data Structures
@@ -71,32 +209,75 @@ private:
     HashMap<double> expenseMap;          // Category → Total expenses
     DoublyLinkedList transactionList;    // Transaction history
     BST transactionBST;                  // Date-sorted transactions
-    MaxHeap expenseHeap;                 // For top expenses
-    CategoryMaxHeap categoryHeap;        // For top spending categories
     BillQueue billQueue;                 // Upcoming bills
     UndoStack undoStack;                 // Undo operations
     TransactionStack recentStack;        // Recent transactions
     Trie categoryTrie;                   // Category autocomplete
     Trie payeeTrie;                      // Payee/description autocomplete
     
+    // Mutations applied since the last takeMutations() (for the write-ahead log)
+    std::vector<Mutation> journal;
+    bool journaling;                     // Off during replay and inside undo
+    bool checkpointRequested;            // Fold the log into snapshots at the next commit
+    
+    // Bumped on every change to a collection, so persistence can tell
+    // which snapshots are stale
+    uint64_t generations[COLLECTION_COUNT];
+    
+    // Expense totals came pre-aggregated from a budgets snapshot, so
+    // transactions loaded afterwards must not add to them again
+    bool expenseTotalsLoaded;
+    
+    void record(const Mutation& m) {
+        if (journaling) journal.push_back(m);
+    }
+    
+    void touch(Collection c) {
+        generations[c]++;
+    }
+    
+    // ID counters, per engine so several engines can share a process. Every
+    // loaded or replayed ID raises them (see seedCounter), so an engine
+    // reloaded within the same second never reissues an ID.
+    int transactionCounter;
+    int billCounter;
+    
+    // Raise a counter to the sequence number of a loaded "<prefix><time>_<n>" ID
+    static void seedCounter(int& counter, std::string_view id, std::string_view prefix) {
+        if (id.substr(0, prefix.size()) != prefix) return;
+        size_t underscore = id.rfind('_');
+        if (underscore < prefix.size() || underscore + 1 == id.size()) return;
+        long long n = 0;
+        for (char c : id.substr(underscore + 1)) {
+            if (c < '0' || c > '9' || n > 100000000) return;
+            n = n * 10 + (c - '0');
+        }
+        if (n > counter) counter = static_cast<int>(n);
+    }
+    
+    void seedCounters(std::string_view id) {
+        seedCounter(transactionCounter, id, "txn_");
+        seedCounter(billCounter, id, "bill_");
+    }
+    
     // Generate unique ID
     std::string generateId() {
-        static int counter = 0;
         std::stringstream ss;
-        ss << "txn_" << std::time(nullptr) << "_" << (++counter);
+        ss << "txn_" << std::time(nullptr) << "_" << (++transactionCounter);
         return ss.str();
     }
     
     std::string generateBillId() {
-        static int counter = 0;
         std::stringstream ss;
-        ss << "bill_" << std::time(nullptr) << "_" << (++counter);
+        ss << "bill_" << std::time(nullptr) << "_" << (++billCounter);
         return ss.str();
     }
     
     // Update expense tracking after transaction
     void updateExpenseTracking(const Transaction& t, bool isAdd) {
         if (t.type != "expense") return;
+        touch(COLL_BUDGETS);
+        ScopedTimer timer(structureHistogram(OP_HASHMAP_UPDATE));
         
         double current = 0;
         expenseMap.search(t.category, current);
@@ -122,9 +303,21 @@ private:
         }
     }
     
-public:
-    FinanceEngine() {
-        // Initialize with default categories
+    // Where a page resumes within the cursor's date
+    static size_t resumeOffset(const std::vector<Transaction>& transactions, const PageCursor& after) {
+        if (after.offset > 0 && after.offset <= transactions.size() &&
+            transactions[after.offset - 1].id == after.id) {
+            return after.offset;
+        }
+        for (size_t i = 0; i < transactions.size(); i++) {
+            if (transactions[i].id == after.id) return i + 1;
+        }
+        // The cursor's transaction is gone; its old position is the best guess
+        return std::min(after.offset, transactions.size());
+    }
+    
+    // Initialize with default categories
+    void insertDefaultCategories() {
         std::vector<std::string> defaultCategories = {
             "Food", "Transport", "Shopping", "Entertainment", "Bills",
             "Healthcare", "Education", "Salary", "Freelance", "Investment",
@@ -136,46 +329,84 @@ public:
         }
     }
     
+public:
+    FinanceEngine()
+        : journaling(true), checkpointRequested(false), expenseTotalsLoaded(false),
+          transactionCounter(0), billCounter(0) {
+        for (int i = 0; i < COLLECTION_COUNT; i++) generations[i] = 0;
+        insertDefaultCategories();
+    }
+    
     // ===== TRANSACTION OPERATIONS =====
     
     // Add a new transaction
     Transaction addTransaction(const std::string& type, double amount, 
                                const std::string& category, const std::string& description,
                                const std::string& date) {
-        Transaction t(generateId(), type, amount, category, description, date);
+        TraceSpan span("engine", __func__);
+        return addTransactionWithId(generateId(), type, amount, category, description, date);
+    }
+    
+    // Add a new transaction under a known ID (also used when replaying the log)
+    Transaction addTransactionWithId(const std::string& id, const std::string& type, double amount,
+                                     const std::string& category, const std::string& description,
+                                     const std::string& date) {
+        TraceSpan span("engine", __func__);
+        seedCounters(id);
+        Transaction t(id, type, amount, category, description, date);
         
         // Add to data structures
-        transactionList.addFront(t);
-        transactionBST.insert(t);
+        touch(COLL_TRANSACTIONS);
+        {
+            ScopedTimer timer(structureHistogram(OP_LIST_INSERT));
+            transactionList.addFront(t);
+        }
+        {
+            ScopedTimer timer(structureHistogram(OP_BST_INSERT));
+            transactionBST.insert(t);
+        }
         recentStack.push(t);
         
         // Update expense tracking
         updateExpenseTracking(t, true);
         
-        // Add to heap if expense
-        if (type == "expense") {
-            expenseHeap.insert(t);
-        }
-        
-        // Add to tries
-        categoryTrie.insert(category);
-        if (!description.empty()) {
-            payeeTrie.insert(description);
+        // Add to tries (the category list is saved with the budgets)
+        touch(COLL_BUDGETS);
+        {
+            ScopedTimer timer(structureHistogram(OP_TRIE_INSERT));
+            categoryTrie.insert(category);
+            if (!description.empty()) {
+                payeeTrie.insert(description);
+            }
         }
         
         // Record for undo
         std::stringstream ss;
         ss << t.id << "|" << t.type << "|" << t.amount << "|" 
            << t.category << "|" << t.description << "|" << t.date;
-        undoStack.push(Action(ADD_TRANSACTION, ss.str()));
+        touch(COLL_UNDO);
+        {
+            ScopedTimer timer(structureHistogram(OP_UNDO_PUSH));
+            undoStack.push(Action(ADD_TRANSACTION, ss.str()));
+        }
+        
+        Mutation m(MUT_ADD_TRANSACTION);
+        m.transaction = t;
+        record(m);
         
         return t;
     }
     
     // Delete transaction by ID
     bool deleteTransaction(const std::string& id) {
+        TraceSpan span("engine", __func__);
         Transaction t;
-        if (!transactionBST.findById(id, t)) {
+        bool found;
+        {
+            ScopedTimer timer(structureHistogram(OP_BST_FIND));
+            found = transactionBST.findById(id, t);
+        }
+        if (!found) {
             return false;
         }
         
@@ -183,46 +414,129 @@ public:
         std::stringstream ss;
         ss << t.id << "|" << t.type << "|" << t.amount << "|" 
            << t.category << "|" << t.description << "|" << t.date;
-        undoStack.push(Action(DELETE_TRANSACTION, ss.str()));
+        touch(COLL_UNDO);
+        {
+            ScopedTimer timer(structureHistogram(OP_UNDO_PUSH));
+            undoStack.push(Action(DELETE_TRANSACTION, ss.str()));
+        }
         
         // Remove from data structures
-        transactionList.deleteById(id);
-        transactionBST.deleteById(id);
+        touch(COLL_TRANSACTIONS);
+        {
+            ScopedTimer timer(structureHistogram(OP_LIST_DELETE));
+            transactionList.deleteById(id);
+        }
+        {
+            ScopedTimer timer(structureHistogram(OP_BST_DELETE));
+            transactionBST.deleteById(id);
+        }
+        recentStack.removeById(id);
         
         // Update expense tracking
         updateExpenseTracking(t, false);
         
+        Mutation m(MUT_DELETE_TRANSACTION);
+        m.key = id;
+        record(m);
+        
         return true;
     }
     
     // Get all transactions
     std::vector<Transaction> getAllTransactions() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
         return transactionList.traverseForward();
     }
     
     // Get transactions sorted by date (ascending)
     std::vector<Transaction> getTransactionsByDateAsc() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_BST_TRAVERSE));
         return transactionBST.inorderTraversal();
     }
     
     // Get transactions sorted by date (descending)
     std::vector<Transaction> getTransactionsByDateDesc() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_BST_TRAVERSE));
         return transactionBST.reverseInorderTraversal();
     }
     
     // Get transactions in date range
     std::vector<Transaction> getTransactionsInRange(const std::string& startDate, 
                                                      const std::string& endDate) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_BST_RANGE));
         return transactionBST.rangeQuery(startDate, endDate);
     }
     
+    // One page of transactions by date within [startDate, endDate] (nullptr =
+    // unbounded), resuming after a cursor: seeks into the date index and stops
+    // after limit records instead of materializing the whole range
+    // Time Complexity: O(log d + limit) plus the emptied dates passed over,
+    // d = distinct dates (the date BST is AVL-balanced)
+    TransactionPage getTransactionPage(const std::string* startDate, const std::string* endDate,
+                                       bool descending, const PageCursor& after, size_t limit) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_BST_RANGE));
+        TransactionPage page;
+        const std::string* lower = startDate;
+        const std::string* upper = endDate;
+        if (after.isSet()) {
+            if (descending && (!upper || after.date < *upper)) upper = &after.date;
+            if (!descending && (!lower || after.date > *lower)) lower = &after.date;
+        }
+        
+        transactionBST.visitRange(lower, upper, descending,
+            [&](const std::string& date, const std::vector<Transaction>& transactions) {
+                size_t i = 0;
+                if (after.isSet() && date == after.date) {
+                    i = resumeOffset(transactions, after);
+                }
+                for (; i < transactions.size(); i++) {
+                    if (page.transactions.size() == limit) {
+                        page.hasMore = true;
+                        return false;
+                    }
+                    page.transactions.push_back(transactions[i]);
+                    page.next.date = date;
+                    page.next.id = transactions[i].id;
+                    page.next.offset = i + 1;
+                }
+                return true;
+            });
+        
+        if (!page.hasMore) page.next = PageCursor();
+        return page;
+    }
+    
+    // Visit transactions by date within [startDate, endDate] (nullptr = unbounded)
+    // straight from the BST, without collecting them; stops when visit returns false
+    // Time Complexity: O(log d + k), d = distinct dates
+    template<typename F>
+    void visitTransactions(const std::string* startDate, const std::string* endDate,
+                           bool descending, F visit) const {
+        TraceSpan span("engine", __func__);
+        transactionBST.visitRange(startDate, endDate, descending,
+            [&](const std::string&, const std::vector<Transaction>& transactions) {
+                for (const auto& t : transactions) {
+                    if (!visit(t)) return false;
+                }
+                return true;
+            });
+    }
+    
     // Get recent transactions (from stack)
     std::vector<Transaction> getRecentTransactions(int count = 10) const {
+        TraceSpan span("engine", __func__);
         return recentStack.getTopN(count);
     }
     
     // Get transactions by category
     std::vector<Transaction> getTransactionsByCategory(const std::string& category) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
         return transactionList.filterByCategory(category);
     }
     
@@ -230,6 +544,7 @@ public:
     
     // Set budget for category
     void setBudget(const std::string& category, double limit) {
+        TraceSpan span("engine", __func__);
         Budget existing;
         double spent = 0;
         expenseMap.search(category, spent);
@@ -238,31 +553,54 @@ public:
             // Update existing
             std::stringstream ss;
             ss << category << "|" << existing.limit;
-            undoStack.push(Action(UPDATE_BUDGET, ss.str()));
+            touch(COLL_UNDO);
+            {
+                ScopedTimer timer(structureHistogram(OP_UNDO_PUSH));
+                undoStack.push(Action(UPDATE_BUDGET, ss.str()));
+            }
             
             existing.limit = limit;
+            touch(COLL_BUDGETS);
+            ScopedTimer timer(structureHistogram(OP_HASHMAP_UPDATE));
             budgetMap.update(category, existing);
         } else {
             // Add new
             std::stringstream ss;
             ss << category << "|" << limit;
-            undoStack.push(Action(ADD_BUDGET, ss.str()));
+            touch(COLL_UNDO);
+            {
+                ScopedTimer timer(structureHistogram(OP_UNDO_PUSH));
+                undoStack.push(Action(ADD_BUDGET, ss.str()));
+            }
             
             Budget b(category, limit, spent);
+            touch(COLL_BUDGETS);
+            ScopedTimer timer(structureHistogram(OP_HASHMAP_UPDATE));
             budgetMap.insert(category, b);
         }
         
-        categoryTrie.insert(category);
+        {
+            ScopedTimer timer(structureHistogram(OP_TRIE_INSERT));
+            categoryTrie.insert(category);
+        }
+        
+        Mutation m(MUT_SET_BUDGET);
+        m.key = category;
+        m.value = limit;
+        record(m);
     }
     
     // Get budget for category
     bool getBudget(const std::string& category, Budget& budget) const {
+        TraceSpan span("engine", __func__);
         return budgetMap.search(category, budget);
     }
     
     // Get all budgets
     std::vector<Budget> getAllBudgets() const {
+        TraceSpan span("engine", __func__);
         std::vector<Budget> result;
+        ScopedTimer timer(structureHistogram(OP_HASHMAP_SCAN));
         auto pairs = budgetMap.getAllPairs();
         for (const auto& pair : pairs) {
             result.push_back(pair.second);
@@ -272,6 +610,7 @@ public:
     
     // Get budget alerts
     std::vector<BudgetAlert> getBudgetAlerts() const {
+        TraceSpan span("engine", __func__);
         std::vector<BudgetAlert> alerts;
         auto budgets = getAllBudgets();
         
@@ -306,36 +645,72 @@ public:
     // Add a bill
     Bill addBill(const std::string& name, double amount, 
                  const std::string& dueDate, const std::string& category) {
-        Bill b(generateBillId(), name, amount, dueDate, category);
-        billQueue.enqueue(b);
+        TraceSpan span("engine", __func__);
+        return addBillWithId(generateBillId(), name, amount, dueDate, category);
+    }
+    
+    // Add a bill under a known ID (also used when replaying the log)
+    Bill addBillWithId(const std::string& id, const std::string& name, double amount,
+                       const std::string& dueDate, const std::string& category) {
+        TraceSpan span("engine", __func__);
+        seedCounters(id);
+        Bill b(id, name, amount, dueDate, category);
+        touch(COLL_BILLS);
+        {
+            ScopedTimer timer(structureHistogram(OP_QUEUE_ENQUEUE));
+            billQueue.enqueue(b);
+        }
         
         std::stringstream ss;
         ss << b.id << "|" << b.name << "|" << b.amount << "|" << b.dueDate << "|" << b.category;
-        undoStack.push(Action(ADD_BILL, ss.str()));
+        touch(COLL_UNDO);
+        {
+            ScopedTimer timer(structureHistogram(OP_UNDO_PUSH));
+            undoStack.push(Action(ADD_BILL, ss.str()));
+        }
+        
+        Mutation m(MUT_ADD_BILL);
+        m.bill = b;
+        record(m);
         
         return b;
     }
     
     // Get all bills
     std::vector<Bill> getAllBills() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_QUEUE_SCAN));
         return billQueue.getAllBills();
     }
     
     // Get unpaid bills
     std::vector<Bill> getUnpaidBills() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_QUEUE_SCAN));
         return billQueue.getUnpaidBills();
     }
     
     // Get overdue bills
     std::vector<Bill> getOverdueBills(const std::string& currentDate) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_QUEUE_SCAN));
         return billQueue.getOverdueBills(currentDate);
     }
     
     // Mark bill as paid
     bool payBill(const std::string& id) {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_QUEUE_SCAN));
         Bill b;
         if (billQueue.findById(id, b)) {
+            touch(COLL_UNDO);
             undoStack.push(Action(PAY_BILL, id));
+            
+            Mutation m(MUT_PAY_BILL);
+            m.key = id;
+            record(m);
+            
+            touch(COLL_BILLS);
             return billQueue.markAsPaid(id);
         }
         return false;
@@ -343,11 +718,20 @@ public:
     
     // Remove bill
     bool removeBill(const std::string& id) {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_QUEUE_SCAN));
         Bill b;
         if (billQueue.findById(id, b)) {
             std::stringstream ss;
             ss << b.id << "|" << b.name << "|" << b.amount << "|" << b.dueDate << "|" << b.category;
+            touch(COLL_UNDO);
             undoStack.push(Action(DELETE_BILL, ss.str()));
+            
+            Mutation m(MUT_DELETE_BILL);
+            m.key = id;
+            record(m);
+            
+            touch(COLL_BILLS);
             return billQueue.removeById(id);
         }
         return false;
@@ -355,23 +739,35 @@ public:
     
     // Get next bill (peek)
     bool getNextBill(Bill& bill) const {
+        TraceSpan span("engine", __func__);
         return billQueue.peek(bill);
     }
     
     // ===== ANALYTICS =====
     
-    // Get top expenses (using heap)
-    std::vector<Transaction> getTopExpenses(int k = 5) {
-        // Rebuild heap with current expenses
-        auto expenses = transactionList.filterByType("expense");
-        expenseHeap.clear();
+    // Get top expenses (using heap). The heap is built per call rather than
+    // kept as a member, so the query is const and safe for concurrent readers.
+    std::vector<Transaction> getTopExpenses(int k = 5) const {
+        TraceSpan span("engine", __func__);
+        std::vector<Transaction> expenses;
+        {
+            ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
+            expenses = transactionList.filterByType("expense");
+        }
+        ScopedTimer timer(structureHistogram(OP_HEAP_TOPK));
+        MaxHeap expenseHeap;
         expenseHeap.buildHeap(expenses);
         return expenseHeap.getTopK(k);
     }
     
     // Get top spending categories
-    std::vector<CategoryAmount> getTopCategories(int k = 5) {
-        auto pairs = expenseMap.getAllPairs();
+    std::vector<CategoryAmount> getTopCategories(int k = 5) const {
+        TraceSpan span("engine", __func__);
+        std::vector<std::pair<std::string, double>> pairs;
+        {
+            ScopedTimer timer(structureHistogram(OP_HASHMAP_SCAN));
+            pairs = expenseMap.getAllPairs();
+        }
         std::vector<CategoryAmount> categories;
         
         for (const auto& pair : pairs) {
@@ -380,17 +776,23 @@ public:
             }
         }
         
-        categoryHeap.clear();
+        ScopedTimer timer(structureHistogram(OP_HEAP_TOPK));
+        CategoryMaxHeap categoryHeap;
         categoryHeap.buildHeap(categories);
         return categoryHeap.getTopK(k);
     }
     
     // Get monthly summary
     MonthlySummary getMonthlySummary(const std::string& yearMonth) const {
+        TraceSpan span("engine", __func__);
         MonthlySummary summary;
         summary.month = yearMonth;
         
-        auto transactions = transactionBST.getByMonth(yearMonth);
+        std::vector<Transaction> transactions;
+        {
+            ScopedTimer timer(structureHistogram(OP_BST_RANGE));
+            transactions = transactionBST.getByMonth(yearMonth);
+        }
         std::unordered_map<std::string, double> categoryTotals;
         
         for (const auto& t : transactions) {
@@ -417,16 +819,21 @@ public:
     
     // Get category suggestions
     std::vector<std::string> getCategorySuggestions(const std::string& prefix) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_TRIE_PREFIX));
         return categoryTrie.getWordsWithPrefix(prefix);
     }
     
     // Get all categories
     std::vector<std::string> getAllCategories() const {
+        TraceSpan span("engine", __func__);
         return categoryTrie.getAllWords();
     }
     
     // Get payee/description suggestions
     std::vector<std::string> getPayeeSuggestions(const std::string& prefix) const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_TRIE_PREFIX));
         return payeeTrie.getWordsWithPrefix(prefix);
     }
     
@@ -434,10 +841,17 @@ public:
     
     // Perform undo
     bool undo() {
+        TraceSpan span("engine", __func__);
         Action action;
         if (!undoStack.pop(action)) {
             return false;
         }
+        touch(COLL_UNDO);
+        
+        // The undo itself is the logged mutation, not the calls it makes below
+        record(Mutation(MUT_UNDO));
+        bool wasJournaling = journaling;
+        journaling = false;
         
         std::stringstream ss(action.data);
         std::string token;
@@ -465,14 +879,17 @@ public:
                 std::getline(ss, date);
                 
                 Transaction t(id, type, amount, category, description, date);
+                touch(COLL_TRANSACTIONS);
                 transactionList.addFront(t);
                 transactionBST.insert(t);
+                recentStack.push(t);  // at the front of the list again, as after a reload
                 updateExpenseTracking(t, true);
                 break;
             }
             case ADD_BUDGET: {
                 // Undo add budget = remove
                 std::getline(ss, token, '|');  // category
+                touch(COLL_BUDGETS);
                 budgetMap.remove(token);
                 break;
             }
@@ -486,6 +903,7 @@ public:
                 Budget b;
                 if (budgetMap.search(category, b)) {
                     b.limit = oldLimit;
+                    touch(COLL_BUDGETS);
                     budgetMap.update(category, b);
                 }
                 break;
@@ -494,6 +912,7 @@ public:
                 break;
         }
         
+        journaling = wasJournaling;
         return true;
     }
     
@@ -506,27 +925,35 @@ public:
     // ===== DATA LOADING =====
     
     // Load transaction from parsed data
-    void loadTransaction(const std::string& id, const std::string& type, double amount,
-                         const std::string& category, const std::string& description,
-                         const std::string& date) {
-        Transaction t(id, type, amount, category, description, date);
+    // Fields may be slices of a file buffer; each is copied once, into the Transaction
+    void loadTransaction(std::string_view id, std::string_view type, double amount,
+                         std::string_view category, std::string_view description,
+                         std::string_view date) {
+        seedCounters(id);
+        Transaction t;
+        t.id.assign(id.data(), id.size());
+        t.type.assign(type.data(), type.size());
+        t.amount = amount;
+        t.category.assign(category.data(), category.size());
+        t.description.assign(description.data(), description.size());
+        t.date.assign(date.data(), date.size());
+        
         transactionList.addBack(t);
         transactionBST.insert(t);
         recentStack.push(t);
-        updateExpenseTracking(t, true);
-        
-        if (type == "expense") {
-            expenseHeap.insert(t);
+        if (!expenseTotalsLoaded) {
+            updateExpenseTracking(t, true);
         }
         
-        categoryTrie.insert(category);
-        if (!description.empty()) {
-            payeeTrie.insert(description);
+        categoryTrie.insert(t.category);
+        if (!t.description.empty()) {
+            payeeTrie.insert(t.description);
         }
     }
     
     // Load budget from parsed data
-    void loadBudget(const std::string& category, double limit) {
+    void loadBudget(std::string_view categoryText, double limit) {
+        std::string category(categoryText);
         double spent = 0;
         expenseMap.search(category, spent);
         Budget b(category, limit, spent);
@@ -534,27 +961,59 @@ public:
         categoryTrie.insert(category);
     }
     
+    // Load a pre-aggregated category expense total (from a snapshot)
+    void loadExpenseTotal(std::string_view category, double total) {
+        expenseMap.insert(std::string(category), total);
+        expenseTotalsLoaded = true;
+    }
+    
+    // Load a known category name (for autocomplete without the transactions)
+    void loadCategory(std::string_view category) {
+        categoryTrie.insert(std::string(category));
+    }
+    
+    // Get per-category expense totals (for persistence)
+    std::vector<std::pair<std::string, double>> getExpenseTotals() const {
+        return expenseMap.getAllPairs();
+    }
+    
     // Load bill from parsed data
-    void loadBill(const std::string& id, const std::string& name, double amount,
-                  const std::string& dueDate, const std::string& category, bool isPaid) {
-        Bill b(id, name, amount, dueDate, category);
+    void loadBill(std::string_view id, std::string_view name, double amount,
+                  std::string_view dueDate, std::string_view category, bool isPaid) {
+        seedCounters(id);
+        Bill b;
+        b.id.assign(id.data(), id.size());
+        b.name.assign(name.data(), name.size());
+        b.amount = amount;
+        b.dueDate.assign(dueDate.data(), dueDate.size());
+        b.category.assign(category.data(), category.size());
         b.isPaid = isPaid;
         billQueue.enqueue(b);
     }
     
     // Clear all data
     void clearAll() {
+        TraceSpan span("engine", __func__);
+        budgetMap.clear();
+        expenseMap.clear();
         transactionList.clear();
         transactionBST.clear();
-        expenseHeap.clear();
         recentStack.clear();
         undoStack.clear();
         billQueue.clear();
+        categoryTrie.clear();
+        payeeTrie.clear();
+        journal.clear();
+        expenseTotalsLoaded = false;
+        insertDefaultCategories();
+        for (int i = 0; i < COLLECTION_COUNT; i++) touch(static_cast<Collection>(i));
     }
     
     // Load undo action from parsed data (for persistence)
-    void loadUndoAction(ActionType type, const std::string& data) {
-        undoStack.push(Action(type, data));
+    // (an action's data starts with the ID it applies to, if any)
+    void loadUndoAction(ActionType type, std::string_view data) {
+        seedCounters(data.substr(0, data.find('|')));
+        undoStack.push(Action(type, std::string(data)));
     }
     
     // Get all undo actions (for persistence)
@@ -564,17 +1023,169 @@ public:
     
     // Clear undo stack
     void clearUndoStack() {
+        TraceSpan span("engine", __func__);
+        touch(COLL_UNDO);
         undoStack.clear();
+        record(Mutation(MUT_CLEAR_UNDO));
+    }
+    
+    // ===== WRITE-AHEAD LOG SUPPORT =====
+    
+    // Current generation of a collection; unchanged means its last snapshot is still exact
+    uint64_t getGeneration(Collection c) const {
+        return generations[c];
+    }
+    
+    // Changes whenever any collection does (generations only grow), so a copy
+    // of the engine is current while this still matches
+    uint64_t getVersion() const {
+        uint64_t version = 0;
+        for (int i = 0; i < COLLECTION_COUNT; i++) version += generations[i];
+        return version;
+    }
+    
+    // Hand over the mutations applied since the last call
+    std::vector<Mutation> takeMutations() {
+        std::vector<Mutation> result;
+        result.swap(journal);
+        return result;
+    }
+    
+    // Ask persistence to checkpoint along with the next takeMutations(),
+    // even when nothing changed
+    void requestCheckpoint() { checkpointRequested = true; }
+    
+    bool takeCheckpointRequest() {
+        bool requested = checkpointRequested;
+        checkpointRequested = false;
+        return requested;
+    }
+    
+    // Re-apply a logged mutation through the normal mutation paths
+    void applyMutation(const Mutation& m) {
+        TraceSpan span("engine", __func__);
+        bool wasJournaling = journaling;
+        journaling = false;
+        
+        switch (m.type) {
+            case MUT_ADD_TRANSACTION: {
+                const Transaction& t = m.transaction;
+                addTransactionWithId(t.id, t.type, t.amount, t.category, t.description, t.date);
+                break;
+            }
+            case MUT_DELETE_TRANSACTION:
+                deleteTransaction(m.key);
+                break;
+            case MUT_SET_BUDGET:
+                setBudget(m.key, m.value);
+                break;
+            case MUT_ADD_BILL: {
+                const Bill& b = m.bill;
+                addBillWithId(b.id, b.name, b.amount, b.dueDate, b.category);
+                break;
+            }
+            case MUT_PAY_BILL:
+                payBill(m.key);
+                break;
+            case MUT_DELETE_BILL:
+                removeBill(m.key);
+                break;
+            case MUT_UNDO:
+                undo();
+                break;
+            case MUT_CLEAR_UNDO:
+                clearUndoStack();
+                break;
+        }
+        
+        journaling = wasJournaling;
     }
     
     // ===== STATISTICS =====
     
+    // Rough resident size, for memory budgets: per-record costs measured on
+    // the DLL + BST + stack + heap copies of a transaction and the other containers
+    size_t approximateMemoryBytes() const {
+        return sizeof(FinanceEngine) +
+               static_cast<size_t>(transactionList.size()) * 768 +
+               static_cast<size_t>(budgetMap.size()) * 256 +
+               static_cast<size_t>(billQueue.size()) * 256 +
+               static_cast<size_t>(undoStack.size()) * 192;
+    }
+    
+    // Walk every structure for its shape and footprint, and flag hash
+    // chains, tree height or dead trie nodes past the STATS_* thresholds
+    // Time Complexity: O(n + trie nodes)
+    EngineStats getEngineStats() const {
+        TraceSpan span("engine", __func__);
+        EngineStats s;
+        s.budgets = budgetMap.stats();
+        s.expenseTotals = expenseMap.stats();
+        s.transactionList = transactionList.stats();
+        s.dateIndex = transactionBST.stats();
+        s.billQueue = billQueue.stats();
+        s.undoStack = undoStack.stats();
+        s.recentStack = recentStack.stats();
+        s.categories = categoryTrie.stats();
+        s.payees = payeeTrie.stats();
+        
+        transactionBST.visitRange(nullptr, nullptr, false,
+            [&](const std::string&, const std::vector<Transaction>& transactions) {
+                for (const auto& t : transactions) {
+                    if (t.type == "expense") s.expenseHeapSize++;
+                }
+                return true;
+            });
+        for (const auto& pair : expenseMap.getAllPairs()) {
+            if (pair.second > 0) s.categoryHeapSize++;
+        }
+        
+        s.totalBytes = sizeof(FinanceEngine) + s.budgets.bytes + s.expenseTotals.bytes +
+                       s.transactionList.bytes + s.dateIndex.bytes + s.billQueue.bytes +
+                       s.undoStack.bytes + s.recentStack.bytes + s.categories.bytes + s.payees.bytes;
+        
+        const HashMapStats* maps[] = {&s.budgets, &s.expenseTotals};
+        const char* mapNames[] = {"budgets", "expense totals"};
+        for (int i = 0; i < 2; i++) {
+            if (maps[i]->meanProbe > STATS_MAX_MEAN_PROBE) {
+                std::stringstream ss;
+                ss << "Hash map " << mapNames[i] << ": " << std::fixed << std::setprecision(1)
+                   << maps[i]->meanProbe << " compares per lookup (chains up to " << maps[i]->maxChain
+                   << " in " << maps[i]->buckets << " buckets)";
+                s.warnings.push_back(ss.str());
+            }
+        }
+        
+        int balancedHeight = 0;
+        while ((1LL << balancedHeight) <= s.dateIndex.nodes) balancedHeight++;
+        if (s.dateIndex.height > STATS_MAX_HEIGHT_FACTOR * std::max(1, balancedHeight)) {
+            std::stringstream ss;
+            ss << "Date BST: height " << s.dateIndex.height << " for " << s.dateIndex.nodes
+               << " dates (balanced: " << balancedHeight << ")";
+            s.warnings.push_back(ss.str());
+        }
+        
+        const TrieStats* tries[] = {&s.categories, &s.payees};
+        const char* trieNames[] = {"category", "payee"};
+        for (int i = 0; i < 2; i++) {
+            if (tries[i]->deadNodes >= STATS_MIN_DEAD_TRIE_NODES && tries[i]->deadNodes * 2 > tries[i]->nodes) {
+                std::stringstream ss;
+                ss << "Trie " << trieNames[i] << ": " << tries[i]->deadNodes << " of " << tries[i]->nodes
+                   << " nodes lead to no word";
+                s.warnings.push_back(ss.str());
+            }
+        }
+        return s;
+    }
+    
     int getTransactionCount() const { return transactionList.size(); }
     int getBudgetCount() const { return budgetMap.size(); }
     int getBillCount() const { return billQueue.size(); }
     
     // Get total balance
     double getTotalBalance() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
         auto transactions = transactionList.traverseForward();
         double balance = 0;
         
@@ -591,6 +1202,8 @@ public:
     
     // Get total income
     double getTotalIncome() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
         auto transactions = transactionList.filterByType("income");
         double total = 0;
         for (const auto& t : transactions) {
@@ -601,6 +1214,8 @@ public:
     
     // Get total expenses
     double getTotalExpenses() const {
+        TraceSpan span("engine", __func__);
+        ScopedTimer timer(structureHistogram(OP_LIST_SCAN));
         auto transactions = transactionList.filterByType("expense");
         double total = 0;
         for (const auto& t : transactions) {
@@ -8,9 +8,23 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include "memory_usage.h"
 
 const int TABLE_SIZE = 100;
 
+// Bucket occupancy and chain lengths (see HashMap::stats)
+struct HashMapStats {
+    int buckets;
+    int usedBuckets;
+    int entries;
+    int maxChain;
+    double meanProbe;   // nodes a successful search compares, on average
+    size_t bytes;       // table, nodes and keys
+    
+    HashMapStats() : buckets(TABLE_SIZE), usedBuckets(0), entries(0), maxChain(0), meanProbe(0), bytes(0) {}
+};
+
 template<typename V>
 struct HashNode {
     std::string key;
@@ -45,6 +59,21 @@ public:
         table.resize(TABLE_SIZE, nullptr);
     }
     
+    // Deep copy; each chain keeps its order
+    // Time Complexity: O(n)
+    HashMap(const HashMap& other) : count(other.count) {
+        table.resize(TABLE_SIZE, nullptr);
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            HashNode<V>** link = &table[i];
+            for (HashNode<V>* node = other.table[i]; node; node = node->next) {
+                *link = new HashNode<V>(node->key, node->value);
+                link = &(*link)->next;
+            }
+        }
+    }
+    
+    HashMap& operator=(const HashMap&) = delete;
+    
     ~HashMap() {
         for (int i = 0; i < TABLE_SIZE; i++) {
             HashNode<V>* current = table[i];
@@ -162,6 +191,42 @@ public:
     
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
+    
+    // The table has a fixed TABLE_SIZE buckets, so chains lengthen as the
+    // map grows; this shows how far
+    // Time Complexity: O(n + TABLE_SIZE)
+    HashMapStats stats() const {
+        HashMapStats s;
+        s.entries = count;
+        s.bytes = table.capacity() * sizeof(HashNode<V>*);
+        long long probes = 0;
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            int chain = 0;
+            for (HashNode<V>* node = table[i]; node; node = node->next) {
+                chain++;
+                probes += chain;
+                s.bytes += sizeof(HashNode<V>) + stringHeapBytes(node->key);
+            }
+            if (chain > 0) s.usedBuckets++;
+            s.maxChain = std::max(s.maxChain, chain);
+        }
+        s.meanProbe = count ? static_cast<double>(probes) / count : 0.0;
+        return s;
+    }
+    
+    // Remove all entries
+    void clear() {
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            HashNode<V>* current = table[i];
+            while (current) {
+                HashNode<V>* temp = current;
+                current = current->next;
+                delete temp;
+            }
+            table[i] = nullptr;
+        }
+        count = 0;
+    }
 };
 
 #endif // HASHMAP_H
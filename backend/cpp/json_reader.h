@@ -0,0 +1,434 @@
+// Streaming JSON Reader for Data Import and Command Parsing
+// Data Structures & Applications Lab Project
+// Operations: walk objects/arrays in one forward pass, read values as slices
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <charconv>
+#include <stdexcept>
+#include "json_scan.h"
+
+// One JSON value as a slice of the source text. Strings keep their raw
+// (still escaped) contents without the quotes; objects and arrays keep
+// their full text. Nothing is copied until a caller asks for it.
+struct JsonValue {
+    enum Kind { NONE, STRING, NUMBER, BOOLEAN, NULL_VALUE, OBJECT, ARRAY };
+    
+    Kind kind;
+    std::string_view raw;
+    bool escaped;           // String contains backslash escapes
+    
+    JsonValue() : kind(NONE), escaped(false) {}
+    
+    bool isMissing() const { return kind == NONE || kind == NULL_VALUE; }
+    bool empty() const { return isMissing() || raw.empty(); }
+    
+    // Text of the value, decoding escapes into scratch only when needed
+    std::string_view text(std::string& scratch) const;
+    
+    std::string str() const {
+        std::string scratch;
+        return std::string(text(scratch));
+    }
+    
+    // Numbers may also arrive as strings ("count":"10"); invalid, partly numeric
+    // ("10abc") or missing gives fallback, and so does a fraction for integer()
+    double number(double fallback = 0.0) const;
+    int integer(int fallback = 0) const;
+    bool toInteger(int& value) const;  // false unless the whole value is an int
+    
+    bool boolean() const { return kind == BOOLEAN && raw == "true"; }
+};
+
+// Append a code point as UTF-8
+inline void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+inline bool parseHex4(std::string_view s, size_t pos, uint32_t& value) {
+    if (pos + 4 > s.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + 4; i++) {
+        char c = s[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+// Decode the escapes of a raw string slice
+// Time Complexity: O(n)
+inline void unescapeJson(std::string_view raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+    
+    size_t i = 0;
+    while (i < raw.size()) {
+        // Copy the run up to the next escape in one go
+        size_t next = raw.find('\\', i);
+        if (next == std::string_view::npos) next = raw.size();
+        out.append(raw.data() + i, next - i);
+        i = next;
+        if (i + 1 >= raw.size()) break;
+        
+        char c = raw[i + 1];
+        i += 2;
+        switch (c) {
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'u': {
+                uint32_t cp;
+                if (!parseHex4(raw, i, cp)) break;
+                i += 4;
+                // Surrogate pair
+                uint32_t low;
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < raw.size() && raw[i] == '\\' &&
+                    raw[i + 1] == 'u' && parseHex4(raw, i + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out.push_back(c); break;   // \" \\ \/
+        }
+    }
+}
+
+inline std::string_view JsonValue::text(std::string& scratch) const {
+    if (kind != STRING) return kind == NUMBER || kind == BOOLEAN ? raw : std::string_view();
+    if (!escaped) return raw;
+    unescapeJson(raw, scratch);
+    return scratch;
+}
+
+inline double parseJsonNumber(std::string_view s, double fallback) {
+    if (s.empty()) return fallback;
+#if defined(__cpp_lib_to_chars)
+    double value = fallback;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (res.ec != std::errc() || res.ptr != s.data() + s.size()) return fallback;
+    return value;
+#else
+    std::string copy(s);
+    char* end = nullptr;
+    double value = std::strtod(copy.c_str(), &end);
+    return end != copy.c_str() + copy.size() ? fallback : value;
+#endif
+}
+
+inline double JsonValue::number(double fallback) const {
+    if (kind != NUMBER && kind != STRING) return fallback;
+    return parseJsonNumber(raw, fallback);
+}
+
+inline bool JsonValue::toInteger(int& value) const {
+    if (kind != NUMBER && kind != STRING) return false;
+    int parsed;
+    auto res = std::from_chars(raw.data(), raw.data() + raw.size(), parsed);
+    if (res.ec != std::errc() || res.ptr != raw.data() + raw.size()) return false;  // e.g. "10.5"
+    value = parsed;
+    return true;
+}
+
+inline int JsonValue::integer(int fallback) const {
+    int value = fallback;
+    toInteger(value);
+    return value;
+}
+
+// Cursor over a JSON text. Each call moves forward; nothing is revisited.
+class JsonReader {
+private:
+    const char* p;
+    const char* end;
+    bool failed;
+    
+    // Optional structural index of the whole text (see json_scan.h)
+    const char* base;
+    const StructuralIndex* index;
+    size_t cursor;
+    
+    // First structural character at or after from, or end. The reader only
+    // moves forward, so the cursor does too: O(1) amortized per call.
+    const char* nextStructural(const char* from) {
+        size_t count = index->size();
+        while (cursor < count && base + (*index)[cursor] < from) cursor++;
+        return cursor < count ? base + (*index)[cursor] : end;
+    }
+    
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    }
+    
+    bool fail() {
+        failed = true;
+        return false;
+    }
+    
+    // Scan a string starting at the opening quote
+    bool scanString(JsonValue& v) {
+        const char* start = ++p;
+        bool escaped = false;
+        if (index) {
+            // Jump from one structural character to the next
+            while (true) {
+                p = nextStructural(p);
+                if (p >= end) return fail();
+                if (*p == '"') {
+                    v.kind = JsonValue::STRING;
+                    v.raw = std::string_view(start, p - start);
+                    v.escaped = escaped;
+                    p++;
+                    return true;
+                }
+                if (*p == '\\') {
+                    escaped = true;
+                    p++;
+                }
+                p++;
+            }
+        }
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                v.kind = JsonValue::STRING;
+                v.raw = std::string_view(start, p - start);
+                v.escaped = escaped;
+                p++;
+                return true;
+            }
+            if (c == '\\') {
+                escaped = true;
+                p++;
+            }
+            p++;
+        }
+        return fail();
+    }
+    
+    // Skip a nested object/array, honouring strings, starting at its opener
+    bool scanNested(JsonValue& v) {
+        const char* start = p;
+        int depth = 0;
+        while (p < end) {
+            if (index) {
+                p = nextStructural(p);
+                if (p >= end) break;
+            }
+            char c = *p;
+            if (c == '"') {
+                JsonValue ignored;
+                if (!scanString(ignored)) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    p++;
+                    v.kind = (*start == '{') ? JsonValue::OBJECT : JsonValue::ARRAY;
+                    v.raw = std::string_view(start, p - start);
+                    return true;
+                }
+            }
+            p++;
+        }
+        return fail();
+    }
+    
+    // One flag per open object/array: no member read yet
+    std::vector<bool> firstMember;
+    
+    bool enter(char open) {
+        skipWhitespace();
+        if (p >= end || *p != open) return fail();
+        p++;
+        firstMember.push_back(true);
+        return true;
+    }
+    
+    // Between members: consume a comma, or leave at the closing bracket
+    bool nextMember(char close) {
+        if (failed || firstMember.empty()) return false;
+        skipWhitespace();
+        if (p >= end) return fail();
+        if (*p == close) {
+            p++;
+            firstMember.pop_back();
+            return false;
+        }
+        if (!firstMember.back()) {
+            if (*p != ',') return fail();
+            p++;
+            skipWhitespace();
+        }
+        firstMember.back() = false;
+        return true;
+    }
+    
+public:
+    JsonReader(std::string_view text, const StructuralIndex* structural = nullptr)
+        : p(text.data()), end(text.data() + text.size()), failed(false),
+          base(text.data()), index(structural), cursor(0) {}
+    
+    bool ok() const { return !failed; }
+    
+    // Only whitespace left
+    bool atEnd() {
+        skipWhitespace();
+        return p >= end;
+    }
+    
+    // Enter an object: consumes '{'
+    bool beginObject() { return enter('{'); }
+    
+    // Next "key": in the current object; false at the closing '}'
+    bool nextKey(std::string_view& key) {
+        if (!nextMember('}')) return false;
+        if (p >= end || *p != '"') return fail();
+        
+        JsonValue k;
+        if (!scanString(k)) return false;
+        key = k.raw;
+        
+        skipWhitespace();
+        if (p >= end || *p != ':') return fail();
+        p++;
+        return true;
+    }
+    
+    // Enter an array: consumes '['
+    bool beginArray() { return enter('['); }
+    
+    // Position on the next element of the current array; false at ']'
+    bool nextElement() { return nextMember(']'); }
+    
+    // Read any value (nested objects/arrays come back whole, unparsed)
+    JsonValue readValue() {
+        JsonValue v;
+        skipWhitespace();
+        if (p >= end) {
+            fail();
+            return v;
+        }
+        
+        char c = *p;
+        if (c == '"') {
+            scanString(v);
+        } else if (c == '{' || c == '[') {
+            scanNested(v);
+        } else {
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                   *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+                p++;
+            }
+            v.raw = std::string_view(start, p - start);
+            if (v.raw == "true" || v.raw == "false") v.kind = JsonValue::BOOLEAN;
+            else if (v.raw == "null") v.kind = JsonValue::NULL_VALUE;
+            else if (!v.raw.empty()) v.kind = JsonValue::NUMBER;
+            else fail();
+        }
+        return v;
+    }
+};
+
+// Members of one JSON object, read in a single pass. Values stay slices of
+// the source text, so the text must outlive the JsonFields.
+class JsonFields {
+private:
+    std::vector<std::pair<std::string_view, JsonValue>> fields;
+    
+public:
+    // Parse an object; returns false if the text is not a well-formed object,
+    // or has anything but whitespace after it
+    bool parse(std::string_view text) {
+        fields.clear();
+        JsonReader reader(text);
+        if (!reader.beginObject()) return false;
+        
+        std::string_view key;
+        while (reader.nextKey(key)) {
+            fields.emplace_back(key, reader.readValue());
+        }
+        return reader.ok() && reader.atEnd();
+    }
+    
+    // Time Complexity: O(number of fields)
+    JsonValue get(std::string_view key) const {
+        for (const auto& field : fields) {
+            if (field.first == key) return field.second;
+        }
+        return JsonValue();
+    }
+    
+    bool has(std::string_view key) const { return !get(key).isMissing(); }
+    
+    std::string getString(std::string_view key) const { return get(key).str(); }
+    double getDouble(std::string_view key) const { return get(key).number(); }
+    
+    // Missing gives fallback; a value that is not a whole number ("10.5",
+    // "ten") is an error rather than being truncated or ignored
+    int getInt(std::string_view key, int fallback) const {
+        JsonValue value = get(key);
+        if (value.isMissing()) return fallback;
+        int result;
+        if (!value.toInteger(result)) {
+            throw std::runtime_error("Invalid " + std::string(key) + ": expected an integer");
+        }
+        return result;
+    }
+};
+
+// Walk {"<arrayKey>":[{...},{...}]} and call onItem(reader) positioned
+// inside each element object; onItem reads that object's keys. Bulk files
+// are indexed up front with the SIMD scanner so strings are skipped in jumps.
+template<typename F>
+bool forEachJsonRecord(std::string_view content, std::string_view arrayKey, F onItem) {
+    StructuralIndex structural;
+    bool indexed = buildStructuralIndex(content, structural);
+    JsonReader reader(content, indexed ? &structural : nullptr);
+    if (!reader.beginObject()) return false;
+    
+    std::string_view key;
+    while (reader.nextKey(key)) {
+        if (key != arrayKey) {
+            reader.readValue();
+            continue;
+        }
+        if (!reader.beginArray()) return false;
+        while (reader.nextElement()) {
+            if (!reader.beginObject()) return false;
+            onItem(reader);
+        }
+    }
+    return reader.ok();
+}
+
+#endif // JSON_READER_H
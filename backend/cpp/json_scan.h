@@ -0,0 +1,167 @@
+// SIMD Structural-Character Scanner for Bulk JSON Ingestion
+// Data Structures & Applications Lab Project
+// Finds " \ { } [ ] , : 16 (SSE2) or 32 (AVX2) bytes at a time
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Offsets of every structural character in a text, in increasing order.
+// JsonReader jumps between these instead of testing each byte.
+typedef std::vector<uint32_t> StructuralIndex;
+
+enum ScanLevel {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+};
+
+inline bool isJsonStructural(unsigned char c) {
+    static const struct Table {
+        bool hit[256];
+        Table() {
+            std::memset(hit, 0, sizeof(hit));
+            const char* chars = "\"\\{}[],:";
+            for (const char* c = chars; *c; c++) hit[(unsigned char)*c] = true;
+        }
+    } table;
+    return table.hit[c];
+}
+
+// Time Complexity: O(n), one byte per step
+inline void scanStructuralScalar(const char* data, size_t length, size_t base, StructuralIndex& out) {
+    for (size_t i = 0; i < length; i++) {
+        if (isJsonStructural((unsigned char)data[i])) {
+            out.push_back(static_cast<uint32_t>(base + i));
+        }
+    }
+}
+
+#ifdef JSON_SCAN_X86
+// Append the set bits of a block mask as offsets
+inline void appendMaskPositions(uint32_t mask, size_t offset, StructuralIndex& out) {
+    while (mask) {
+        out.push_back(static_cast<uint32_t>(offset + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+// Clearing bit 5 folds '{' onto '[' and '}' onto ']', saving two compares
+__attribute__((target("sse2")))
+inline void scanStructuralSse2(const char* data, size_t length, StructuralIndex& out) {
+    const __m128i fold = _mm_set1_epi8((char)0xDF);
+    const __m128i open = _mm_set1_epi8('[');
+    const __m128i close = _mm_set1_epi8(']');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i colon = _mm_set1_epi8(':');
+    
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i folded = _mm_and_si128(chunk, fold);
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, colon))));
+        appendMaskPositions(static_cast<uint32_t>(_mm_movemask_epi8(hits)), i, out);
+    }
+    scanStructuralScalar(data + i, length - i, i, out);
+}
+
+__attribute__((target("avx2")))
+inline void scanStructuralAvx2(const char* data, size_t length, StructuralIndex& out) {
+    const __m256i fold = _mm256_set1_epi8((char)0xDF);
+    const __m256i open = _mm256_set1_epi8('[');
+    const __m256i close = _mm256_set1_epi8(']');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i colon = _mm256_set1_epi8(':');
+    
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i folded = _mm256_and_si256(chunk, fold);
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, comma), _mm256_cmpeq_epi8(chunk, colon))));
+        appendMaskPositions(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), i, out);
+    }
+    scanStructuralScalar(data + i, length - i, i, out);
+}
+#endif
+
+// Best scanner this CPU supports (CPUID via the compiler builtins), decided
+// once. FINANCE_JSON_SCAN=scalar|sse2|avx2 lowers it, e.g. for comparisons.
+inline ScanLevel detectScanLevel() {
+    ScanLevel level = SCAN_SCALAR;
+#ifdef JSON_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) level = SCAN_AVX2;
+    else if (__builtin_cpu_supports("sse2")) level = SCAN_SSE2;
+#endif
+    
+    const char* forced = std::getenv("FINANCE_JSON_SCAN");
+    if (forced) {
+        ScanLevel wanted = level;
+        if (std::strcmp(forced, "scalar") == 0) wanted = SCAN_SCALAR;
+        else if (std::strcmp(forced, "sse2") == 0) wanted = SCAN_SSE2;
+        else if (std::strcmp(forced, "avx2") == 0) wanted = SCAN_AVX2;
+        if (wanted < level) level = wanted;
+    }
+    return level;
+}
+
+inline ScanLevel scanLevel() {
+    static const ScanLevel level = detectScanLevel();
+    return level;
+}
+
+inline const char* scanLevelName(ScanLevel level) {
+    switch (level) {
+        case SCAN_AVX2: return "avx2";
+        case SCAN_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+// Build the structural index of a text. Offsets are 32-bit, so texts of
+// 4 GiB or more get no index (and JsonReader falls back to byte scanning).
+// Time Complexity: O(n)
+inline bool buildStructuralIndex(std::string_view text, StructuralIndex& out) {
+    out.clear();
+    if (text.size() >= UINT32_MAX) return false;
+    out.reserve(text.size() / 6 + 16);
+    
+    switch (scanLevel()) {
+#ifdef JSON_SCAN_X86
+        case SCAN_AVX2:
+            scanStructuralAvx2(text.data(), text.size(), out);
+            break;
+        case SCAN_SSE2:
+            scanStructuralSse2(text.data(), text.size(), out);
+            break;
+#endif
+        default:
+            scanStructuralScalar(text.data(), text.size(), 0, out);
+            break;
+    }
+    return true;
+}
+
+#endif // JSON_SCAN_H
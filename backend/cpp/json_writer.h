@@ -0,0 +1,204 @@
+// Append-Only JSON Writer for Responses and Exports
+// Data Structures & Applications Lab Project
+// Operations: append literals, escaped strings and fixed-2 numbers to one reusable buffer,
+//             optionally draining it to a file or socket while a long result is produced,
+//             and checksum a response across its drained chunks
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <cstdint>
+#include <charconv>
+#include "checksum.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Chunk size at which streamed output is handed to the sink
+const size_t JSON_STREAM_CHUNK_BYTES = 1 << 16;
+
+// Output buffer that only grows. clear() keeps the capacity, so a writer
+// reused across requests stops allocating once it has seen the largest one.
+// With a sink attached, long results can drain() as they are produced and
+// memory stays bounded by one chunk.
+class JsonWriter {
+private:
+    std::string buffer;
+    size_t flushed;         // Bytes already handed to a file/fd
+    FILE* sinkFile;
+    int sinkFd;
+    bool digesting;
+    uint32_t digest;        // CRC-32C of the bytes since beginDigest()...
+    size_t digested;        // ...up to this position()
+    
+    // Fold the bytes not yet digested into the digest (before they leave the buffer)
+    void digestBuffered() {
+        if (!digesting) return;
+        size_t from = digested > flushed ? digested - flushed : 0;
+        if (from < buffer.size()) {
+            digest = Crc32c::instance().update(digest, buffer.data() + from, buffer.size() - from);
+        }
+        digested = position();
+    }
+
+public:
+    JsonWriter() : flushed(0), sinkFile(nullptr), sinkFd(-1), digesting(false), digest(0), digested(0) {}
+    
+    // Structural text and keys, copied as-is: out.raw("{\"id\":")
+    JsonWriter& raw(std::string_view text) {
+        buffer.append(text.data(), text.size());
+        return *this;
+    }
+    
+    JsonWriter& raw(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+    
+    // Quoted string; runs that need no escaping are copied in one append
+    // Time Complexity: O(n)
+    JsonWriter& string(std::string_view s) {
+        buffer.push_back('"');
+        size_t runStart = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            
+            buffer.append(s.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+                case '"': buffer.append("\\\"", 2); break;
+                case '\\': buffer.append("\\\\", 2); break;
+                case '\n': buffer.append("\\n", 2); break;
+                case '\r': buffer.append("\\r", 2); break;
+                case '\t': buffer.append("\\t", 2); break;
+                default: {
+                    static const char hex[] = "0123456789abcdef";
+                    char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    buffer.append(escape, 6);
+                }
+            }
+        }
+        buffer.append(s.data() + runStart, s.size() - runStart);
+        buffer.push_back('"');
+        return *this;
+    }
+    
+    // Money and percentages: always two decimals, like std::fixed << setprecision(2)
+    JsonWriter& number(double value) {
+        char digits[64];
+#if defined(__cpp_lib_to_chars)
+        auto res = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 2);
+        size_t length = (res.ec == std::errc()) ? static_cast<size_t>(res.ptr - digits) : 0;
+#else
+        int written = std::snprintf(digits, sizeof(digits), "%.2f", value);
+        size_t length = written > 0 ? static_cast<size_t>(written) : 0;
+#endif
+        if (length == 0) {
+            // Only magnitudes beyond the buffer end up here
+            length = std::snprintf(digits, sizeof(digits), "%.2e", value);
+        }
+        buffer.append(digits, length);
+        return *this;
+    }
+    
+    JsonWriter& integer(long long value) {
+        char digits[24];
+        auto res = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, res.ptr - digits);
+        return *this;
+    }
+    
+    JsonWriter& boolean(bool value) {
+        return value ? raw("true") : raw("false");
+    }
+    
+    // Comma before every array element but the first
+    JsonWriter& separator(size_t index) {
+        if (index > 0) buffer.push_back(',');
+        return *this;
+    }
+    
+    const char* data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }      // Bytes buffered, not yet flushed
+    bool empty() const { return buffer.empty(); }
+    const std::string& str() const { return buffer; }
+    
+    void clear() { buffer.clear(); }
+    
+    // Total bytes written so far, flushed or not; a mark for truncate()
+    size_t position() const { return flushed + buffer.size(); }
+    
+    // Drop everything written after a position() mark. Output already
+    // flushed cannot be taken back, so this stops at the flushed boundary.
+    void truncate(size_t mark) {
+        size_t keep = mark > flushed ? mark - flushed : 0;
+        if (keep < buffer.size()) buffer.resize(keep);
+    }
+    
+    // Checksum everything written from here to endDigest(), including output
+    // drained to the sink on the way (the request capture log uses this)
+    void beginDigest() {
+        digesting = true;
+        digest = 0;
+        digested = position();
+    }
+    
+    // Time Complexity: O(bytes since the last flush)
+    uint32_t endDigest() {
+        digestBuffered();
+        digesting = false;
+        return digest;
+    }
+    
+    // Where drain() sends output (nullptr / -1 detaches)
+    void setSink(FILE* file) { sinkFile = file; sinkFd = -1; }
+    void setSink(int fd) { sinkFd = fd; sinkFile = nullptr; }
+    bool hasSink() const { return sinkFile || sinkFd >= 0; }
+    
+    // Hand the buffer to the sink once it holds at least threshold bytes.
+    // Call between records, so a chunk never ends mid-record.
+    bool drain(size_t threshold = JSON_STREAM_CHUNK_BYTES) {
+        if (buffer.size() < threshold) return true;
+        if (sinkFile) return flushTo(sinkFile);
+#ifndef _WIN32
+        if (sinkFd >= 0) return flushTo(sinkFd);
+#endif
+        return true;
+    }
+    
+    // Drain the buffer to a stream; the buffer is emptied either way
+    bool flushTo(FILE* file) {
+        digestBuffered();
+        bool ok = buffer.empty() || std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        flushed += buffer.size();
+        buffer.clear();
+        return ok;
+    }
+
+#ifndef _WIN32
+    bool flushTo(int fd) {
+        digestBuffered();
+        flushed += buffer.size();
+        size_t written = 0;
+        while (written < buffer.size()) {
+            ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                buffer.clear();
+                return false;
+            }
+            written += n;
+        }
+        buffer.clear();
+        return true;
+    }
+#endif
+};
+
+#endif // JSON_WRITER_H
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include "memory_usage.h"
 
 struct Transaction {
     std::string id;
@@ -23,6 +24,12 @@ struct Transaction {
         : id(i), type(t), amount(a), category(c), description(d), date(dt) {}
 };
 
+// Bytes a transaction's strings hold outside the struct
+inline size_t transactionHeapBytes(const Transaction& t) {
+    return stringHeapBytes(t.id) + stringHeapBytes(t.type) + stringHeapBytes(t.category) +
+           stringHeapBytes(t.description) + stringHeapBytes(t.date);
+}
+
 struct DLLNode {
     Transaction data;
     DLLNode* prev;
@@ -40,6 +47,16 @@ private:
 public:
     DoublyLinkedList() : head(nullptr), tail(nullptr), count(0) {}
     
+    // Deep copy
+    // Time Complexity: O(n)
+    DoublyLinkedList(const DoublyLinkedList& other) : head(nullptr), tail(nullptr), count(0) {
+        for (DLLNode* node = other.head; node; node = node->next) {
+            addBack(node->data);
+        }
+    }
+    
+    DoublyLinkedList& operator=(const DoublyLinkedList&) = delete;
+    
     ~DoublyLinkedList() {
         DLLNode* current = head;
         while (current) {
@@ -206,6 +223,17 @@ public:
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
     
+    // Node count and footprint
+    // Time Complexity: O(n)
+    ContainerStats stats() const {
+        ContainerStats s;
+        for (DLLNode* node = head; node; node = node->next) {
+            s.size++;
+            s.bytes += sizeof(DLLNode) + transactionHeapBytes(node->data);
+        }
+        return s;
+    }
+    
     // Clear all transactions
     void clear() {
         DLLNode* current = head;
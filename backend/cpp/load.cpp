@@ -0,0 +1,415 @@
+// Fixed-Rate Load Generator for the Resident Finance Engine
+// Data Structures & Applications Lab Project
+// Drives --serve at stepped request rates with a read/write mix, records latency corrected for
+// coordinated omission, and finds the highest rate each mix sustains
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+#include "datagen.h"
+#include "metrics.h"
+#include "bench_support.h"
+
+#ifndef _WIN32
+// ===== MIXES =====
+// Reads are drawn by weight. Writes come in bursts: after every burstEvery
+// reads a connection sends burstLength add_transaction requests back to
+// back, the way an import or a busy user hits the engine.
+
+struct LoadContext {
+    SplitMix64 rng;
+    long long endDay;
+    long long span;
+    
+    LoadContext(uint64_t seed, long long end, long long days) : rng(seed), endDay(end), span(days) {}
+    
+    std::string randomDate() { return civilFromDays(endDay - static_cast<long long>(rng.below(span))); }
+    const char* randomCategory() { return GEN_EXPENSE_CATEGORIES[rng.below(GEN_EXPENSE_COUNT)].name; }
+};
+
+std::string params(const char* command, const std::string& fields) {
+    return std::string("{\"command\":\"") + command + "\",\"params\":{" + fields + "}}";
+}
+
+std::string jsonText(const std::string& s) {
+    return "\"" + s + "\"";
+}
+
+struct LoadRead {
+    const char* name;
+    std::string (*makeRequest)(LoadContext&);
+};
+
+const LoadRead LOAD_READS[] = {
+    {"get_dashboard", [](LoadContext&) { return params("get_dashboard", ""); }},
+    {"get_transactions", [](LoadContext&) { return params("get_transactions", "\"limit\":50"); }},
+    {"get_alerts", [](LoadContext&) { return params("get_alerts", ""); }},
+    {"get_bills", [](LoadContext&) { return params("get_bills", ""); }},
+    {"get_category_suggestions", [](LoadContext& c) {
+        return params("get_category_suggestions", "\"prefix\":" + jsonText(std::string(c.randomCategory()).substr(0, 1)));
+    }},
+};
+const size_t LOAD_READ_COUNT = sizeof(LOAD_READS) / sizeof(LOAD_READS[0]);
+
+std::string makeWrite(LoadContext& c) {
+    return params("add_transaction", "\"type\":\"expense\",\"amount\":" + std::to_string(1 + c.rng.below(200)) +
+                  ",\"category\":" + jsonText(c.randomCategory()) + ",\"description\":\"Load\",\"date\":" +
+                  jsonText(c.randomDate()));
+}
+
+struct LoadMix {
+    const char* name;
+    unsigned weights[LOAD_READ_COUNT];  // in LOAD_READS order
+    unsigned burstEvery;                // reads between write bursts (0: no writes)
+    unsigned burstLength;
+};
+
+const LoadMix LOAD_MIXES[] = {
+    {"read-only",   {70, 15, 10, 3, 2}, 0, 0},
+    {"dashboard",   {70, 15, 10, 3, 2}, 190, 10},   // 5% writes
+    {"write-burst", {70, 15, 10, 3, 2}, 60, 20},    // 25% writes
+};
+
+// One connection's request stream
+class MixCursor {
+private:
+    const LoadMix& mix;
+    unsigned totalWeight;
+    unsigned position;      // within one read stretch + burst
+
+public:
+    MixCursor(const LoadMix& loadMix, unsigned offset) : mix(loadMix), totalWeight(0), position(0) {
+        for (unsigned w : mix.weights) totalWeight += w;
+        unsigned period = mix.burstEvery + mix.burstLength;
+        if (period > 0) position = offset % period;     // connections burst at different times
+    }
+    
+    std::string next(LoadContext& c) {
+        unsigned period = mix.burstEvery + mix.burstLength;
+        bool write = mix.burstLength > 0 && position >= mix.burstEvery;
+        position = period > 0 ? (position + 1) % period : 0;
+        if (write) return makeWrite(c);
+        
+        unsigned pick = static_cast<unsigned>(c.rng.below(totalWeight));
+        for (size_t i = 0; i < LOAD_READ_COUNT; i++) {
+            if (pick < mix.weights[i]) return LOAD_READS[i].makeRequest(c);
+            pick -= mix.weights[i];
+        }
+        return LOAD_READS[0].makeRequest(c);
+    }
+};
+
+// ===== RUNS =====
+
+struct LoadOptions {
+    std::string engine;
+    std::string workDir;
+    std::string csvPath;
+    std::vector<std::string> mixes;     // empty: all
+    std::vector<double> rates;          // explicit steps; otherwise a ramp
+    double startRate;
+    double rateFactor;
+    double maxRate;
+    double seconds;                     // per step
+    double sloMs;                       // p99 a step must meet to count as sustained
+    unsigned connections;
+    bool pipe;
+    std::vector<std::string> engineArgs;
+    DataGenOptions data;
+    
+    LoadOptions() : engine("./finance_engine"), workDir("load_data"), startRate(250), rateFactor(2),
+                    maxRate(1e6), seconds(5), sloMs(10), connections(4), pipe(false) {
+        data.transactions = 10000;
+    }
+};
+
+struct StepResult {
+    std::string mix;
+    double target;          // requests per second
+    double achieved;
+    uint64_t p50;           // ns, corrected for coordinated omission
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    uint64_t serviceP99;    // ns from send to response, as a naive client sees it
+    uint64_t errors;
+    bool sustained;
+};
+
+// Everything the connection threads of one step share
+struct StepState {
+    LatencyHistogram latency;   // from the scheduled send time
+    LatencyHistogram service;   // from the actual send time
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> completed;
+    std::atomic<bool> failed;
+    
+    StepState() : errors(0), completed(0), failed(false) {}
+};
+
+// Send on a fixed schedule: request k of this connection is due at
+// start + offset + k * interval. A client that waits for a slow response
+// sends the next requests late; timing them from when they were due (not
+// from when they went out) charges the stall to every request it delayed,
+// which is what users queued behind it would see. Without that correction
+// the stall is counted once and the percentiles look far better than they
+// are (coordinated omission). Sending stops at the end of the step, so an
+// overloaded step leaves requests unsent and its percentiles are a floor.
+void runConnection(LineChannel& channel, const LoadMix& mix, LoadContext context, unsigned index,
+                   Clock::time_point start, Clock::duration offset, Clock::duration interval,
+                   Clock::time_point end, StepState& state) {
+    MixCursor cursor(mix, index * 37);
+    std::string response;
+    for (Clock::time_point due = start + offset; due < end && Clock::now() < end; due += interval) {
+        std::string request = cursor.next(context);
+        std::this_thread::sleep_until(due);
+        Clock::time_point sent = Clock::now();
+        if (!channel.request(request, response)) {
+            state.failed.store(true);
+            return;
+        }
+        Clock::time_point done = Clock::now();
+        state.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - due).count());
+        state.service.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count());
+        if (response.compare(0, 9, "{\"error\":") == 0) state.errors.fetch_add(1, std::memory_order_relaxed);
+        state.completed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool runStep(const LoadOptions& options, const LoadMix& mix, std::vector<LineChannel*>& channels,
+             double rate, uint64_t seed, long long endDay, StepResult& result) {
+    StepState state;
+    size_t count = channels.size();
+    Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(count / rate));
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.seconds));
+    long long span = std::max(1, options.data.years) * 365LL;
+    
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; i++) {
+        Clock::duration offset = interval * static_cast<long>(i) / static_cast<long>(count);
+        LoadContext context(seed + i, endDay, span);
+        threads.emplace_back(runConnection, std::ref(*channels[i]), std::cref(mix), context,
+                             static_cast<unsigned>(i), start, offset, interval, end, std::ref(state));
+    }
+    for (auto& thread : threads) thread.join();
+    if (state.failed.load()) return false;
+    
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    result.mix = mix.name;
+    result.target = rate;
+    result.achieved = state.completed.load() / elapsed;
+    result.p50 = state.latency.percentile(0.50);
+    result.p99 = state.latency.percentile(0.99);
+    result.p999 = state.latency.percentile(0.999);
+    result.max = state.latency.max();
+    result.serviceP99 = state.service.percentile(0.99);
+    result.errors = state.errors.load();
+    result.sustained = result.achieved >= 0.95 * rate && result.p99 <= options.sloMs * 1e6;
+    return true;
+}
+
+void printStep(const StepResult& r) {
+    std::cout << std::left << std::setw(13) << r.mix << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << r.target << std::setw(11) << r.achieved << std::setprecision(1)
+              << std::setw(11) << r.p50 / 1000.0 << std::setw(11) << r.p99 / 1000.0
+              << std::setw(11) << r.p999 / 1000.0 << std::setw(11) << r.max / 1000.0
+              << std::setw(12) << r.serviceP99 / 1000.0 << std::setw(8) << r.errors
+              << (r.sustained ? "" : "  over") << std::endl;
+}
+
+// Fresh data and a fresh engine for each mix, then rates in increasing
+// steps until one is not sustained
+bool runMix(const LoadOptions& options, const LoadMix& mix, std::vector<StepResult>& results, double& best) {
+    std::string dataDir = options.workDir + "/" + mix.name;
+    std::error_code error;
+    std::filesystem::remove_all(dataDir, error);  // drop the snapshots and log of an earlier run
+    if (!ensureDirectory(options.workDir) || !ensureDirectory(dataDir) || !generateData(dataDir, options.data)) {
+        std::cerr << "Error: cannot generate data in " << dataDir << std::endl;
+        return false;
+    }
+    long long endDay = 0;
+    parseCivil(options.data.endDate, endDay);   // generateData checked it
+    
+    std::vector<std::string> args = {dataDir, "--serve"};
+    std::string socketPath = options.workDir + "/engine.sock";
+    if (!options.pipe) {
+        // A worker serves one connection until it closes: one worker per connection
+        args.insert(args.end(), {"--socket", socketPath, "--workers", std::to_string(options.connections)});
+    }
+    args.insert(args.end(), options.engineArgs.begin(), options.engineArgs.end());
+    EngineProcess engine;
+    if (!engine.start(options.engine, args)) {
+        std::cerr << "Error: cannot start " << options.engine << std::endl;
+        return false;
+    }
+    
+    std::vector<LineChannel*> channels;
+    std::vector<EngineConnection> connections(options.pipe ? 0 : options.connections);
+    if (options.pipe) channels.push_back(&engine);
+    for (auto& connection : connections) {
+        if (!connection.connect(socketPath, 10000)) {
+            std::cerr << "Error: cannot connect to " << socketPath << std::endl;
+            engine.stop();
+            return false;
+        }
+        channels.push_back(&connection);
+    }
+    
+    // Load the snapshots before the clock starts
+    std::string response;
+    if (!channels[0]->request(params("get_dashboard", ""), response)) return false;
+    
+    std::vector<double> rates = options.rates;
+    if (rates.empty()) {
+        for (double rate = options.startRate; rate <= options.maxRate; rate *= options.rateFactor) rates.push_back(rate);
+    }
+    
+    best = 0;
+    bool ok = true;
+    for (size_t i = 0; i < rates.size(); i++) {
+        StepResult result;
+        if (!runStep(options, mix, channels, rates[i], options.data.seed + i * 1000, endDay, result)) {
+            std::cerr << "Error: engine stopped during " << mix.name << " at " << rates[i] << " req/s" << std::endl;
+            ok = false;
+            break;
+        }
+        results.push_back(result);
+        printStep(result);
+        if (result.sustained) best = std::max(best, result.achieved);
+        else if (options.rates.empty()) break;
+    }
+    
+    for (auto& connection : connections) connection.close();
+    if (options.pipe) engine.finish();
+    else engine.stop();
+    return ok;
+}
+
+bool writeCsv(const std::string& path, const std::vector<StepResult>& results) {
+    std::ofstream csv(path);
+    if (!csv) return false;
+    csv << "mix,target_rps,achieved_rps,p50_us,p99_us,p999_us,max_us,service_p99_us,errors,sustained\n";
+    for (const auto& r : results) {
+        csv << r.mix << "," << r.target << "," << r.achieved << "," << r.p50 / 1000.0 << "," << r.p99 / 1000.0
+            << "," << r.p999 / 1000.0 << "," << r.max / 1000.0 << "," << r.serviceP99 / 1000.0 << ","
+            << r.errors << "," << (r.sustained ? 1 : 0) << "\n";
+    }
+    return static_cast<bool>(csv);
+}
+
+std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* p = text; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) items.push_back(item);
+            item.clear();
+            if (*p == '\0') break;
+        } else {
+            item += *p;
+        }
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]) {
+    // Parse arguments: [--engine PATH] [--mix read-only,dashboard,write-burst]
+    // [--rates 500,1000,...] [--start-rate N] [--rate-factor F] [--max-rate N]
+    // [--seconds S] [--slo-ms MS] [--connections N] [--pipe] [--size N] [--seed N]
+    // [--work DIR] [--csv FILE] [-- engine flags...]
+    LoadOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc) {
+            options.engine = argv[++i];
+        } else if (arg == "--mix" && i + 1 < argc) {
+            options.mixes = splitList(argv[++i]);
+        } else if (arg == "--rates" && i + 1 < argc) {
+            for (const auto& rate : splitList(argv[++i])) {
+                double value = std::strtod(rate.c_str(), nullptr);
+                if (value > 0) options.rates.push_back(value);
+            }
+        } else if (arg == "--start-rate" && i + 1 < argc) {
+            options.startRate = std::max(1.0, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--rate-factor" && i + 1 < argc) {
+            options.rateFactor = std::max(1.05, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--max-rate" && i + 1 < argc) {
+            options.maxRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::max(0.1, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--slo-ms" && i + 1 < argc) {
+            options.sloMs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--connections" && i + 1 < argc) {
+            options.connections = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--pipe") {
+            options.pipe = true;
+        } else if (arg == "--size" && i + 1 < argc) {
+            options.data.transactions = static_cast<size_t>(std::max(1.0, std::strtod(argv[++i], nullptr)));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.data.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--work" && i + 1 < argc) {
+            options.workDir = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--") {
+            options.engineArgs.assign(argv + i + 1, argv + argc);
+            break;
+        }
+    }
+    
+    std::vector<const LoadMix*> mixes;
+    for (const auto& mix : LOAD_MIXES) {
+        if (options.mixes.empty() || std::find(options.mixes.begin(), options.mixes.end(), mix.name) != options.mixes.end()) {
+            mixes.push_back(&mix);
+        }
+    }
+    if (mixes.empty()) {
+        std::cerr << "Error: no such mix (read-only, dashboard, write-burst)" << std::endl;
+        return 1;
+    }
+    
+    signal(SIGPIPE, SIG_IGN);   // a crashed engine shows up as a failed write
+    
+    std::cout << std::left << std::setw(13) << "mix" << std::right << std::setw(10) << "target/s"
+              << std::setw(11) << "achieved/s" << std::setw(11) << "p50 us" << std::setw(11) << "p99 us"
+              << std::setw(11) << "p999 us" << std::setw(11) << "max us" << std::setw(12) << "svc p99 us"
+              << std::setw(8) << "errors" << std::endl;
+    
+    std::vector<StepResult> results;
+    std::vector<double> sustained;
+    for (const LoadMix* mix : mixes) {
+        double best = 0;
+        if (!runMix(options, *mix, results, best)) return 1;
+        sustained.push_back(best);
+    }
+    
+    std::cout << "\nMax sustained throughput (p99 <= " << options.sloMs << " ms, >= 95% of the target rate):" << std::endl;
+    for (size_t i = 0; i < mixes.size(); i++) {
+        std::cout << "  " << std::left << std::setw(13) << mixes[i]->name << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(10) << sustained[i] << " req/s" << std::endl;
+    }
+    
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        std::cerr << "Error: cannot write " << options.csvPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#else
+int main() {
+    std::cerr << "finance_load needs POSIX pipes and sockets; it is not supported on this platform" << std::endl;
+    return 1;
+}
+#endif
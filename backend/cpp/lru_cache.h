@@ -0,0 +1,100 @@
+// LRU Cache Implementation for Resident Per-Tenant Engines
+// Data Structures & Applications Lab Project
+// Operations: get (mark most recent), put, per-entry cost, evict least recent over a budget (handing the values over)
+
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// Owns its values. A doubly linked list keeps entries in recency order
+// (front = most recently used) and a hash map finds an entry's list node.
+template<typename V>
+class LruCache {
+private:
+    struct Entry {
+        std::string key;
+        std::unique_ptr<V> value;
+        size_t cost;
+    };
+    
+    std::list<Entry> entries;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+    size_t totalCost;
+
+public:
+    LruCache() : totalCost(0) {}
+    
+    // Find a value and mark it most recently used; nullptr if absent
+    // Time Complexity: O(1) average
+    V* get(const std::string& key) {
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->value.get();
+    }
+    
+    // Insert (or replace) a value as most recently used
+    // Time Complexity: O(1) average
+    V* put(const std::string& key, std::unique_ptr<V> value, size_t cost = 0) {
+        remove(key);
+        entries.push_front(Entry{key, std::move(value), cost});
+        index[key] = entries.begin();
+        totalCost += cost;
+        return entries.front().value.get();
+    }
+    
+    // Update an entry's cost (e.g. after it grew)
+    void setCost(const std::string& key, size_t cost) {
+        auto it = index.find(key);
+        if (it == index.end()) return;
+        totalCost = totalCost - it->second->cost + cost;
+        it->second->cost = cost;
+    }
+    
+    bool remove(const std::string& key) {
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        totalCost -= it->second->cost;
+        entries.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+    
+    // Evict least recently used entries until the total cost fits the budget,
+    // skipping those canEvict(key, value) refuses (e.g. still in use).
+    // onEvict(key, std::unique_ptr<V>) takes over each evicted value, so the
+    // caller can finish with it after releasing its own locks.
+    // Time Complexity: O(entries scanned)
+    template<typename P, typename F>
+    size_t evictOver(size_t budget, P canEvict, F onEvict) {
+        size_t evicted = 0;
+        auto it = entries.end();
+        while (totalCost > budget && it != entries.begin()) {
+            --it;
+            if (!canEvict(it->key, *it->value)) continue;
+            
+            onEvict(it->key, std::move(it->value));
+            totalCost -= it->cost;
+            index.erase(it->key);
+            it = entries.erase(it);
+            evicted++;
+        }
+        return evicted;
+    }
+    
+    // Visit every entry, most recently used first
+    template<typename F>
+    void forEach(F visit) {
+        for (auto& entry : entries) visit(entry.key, *entry.value);
+    }
+    
+    size_t size() const { return entries.size(); }
+    size_t cost() const { return totalCost; }
+    bool isEmpty() const { return entries.empty(); }
+};
+
+#endif // LRU_CACHE_H
@@ -3,589 +3,2108 @@
 // Data Structures & Applications Lab Project
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <vector>
 #include <ctime>
-#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <memory>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <unordered_set>
 #include "finance_engine.h"
+#include "snapshot.h"
+#include "wal.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "lru_cache.h"
+#include "perfect_hash.h"
+#include "epoch.h"
+#include "fileutil.h"
+#include "metrics.h"
+#include "trace.h"
 
-// Simple JSON parsing helpers (for academic purposes - no external libraries)
-std::string trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r\"");
-    if (first == std::string::npos) return "";
-    size_t last = str.find_last_not_of(" \t\n\r\"");
-    return str.substr(first, (last - first + 1));
-}
-
-std::string extractValue(const std::string& json, const std::string& key) {
-    size_t pos = json.find("\"" + key + "\"");
-    if (pos == std::string::npos) return "";
-    
-    pos = json.find(":", pos);
-    if (pos == std::string::npos) return "";
-    
-    size_t start = json.find_first_not_of(" \t\n\r", pos + 1);
-    if (start == std::string::npos) return "";
-    
-    if (json[start] == '"') {
-        size_t end = json.find("\"", start + 1);
-        return json.substr(start + 1, end - start - 1);
-    } else if (json[start] == '[' || json[start] == '{') {
-        int depth = 1;
-        char open = json[start];
-        char close = (open == '[') ? ']' : '}';
-        size_t end = start + 1;
-        while (depth > 0 && end < json.length()) {
-            if (json[end] == open) depth++;
-            else if (json[end] == close) depth--;
-            end++;
-        }
-        return json.substr(start, end - start);
-    } else {
-        size_t end = json.find_first_of(",}\n", start);
-        return trim(json.substr(start, end - start));
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#endif
+
+// JSON output helpers: each appends one object to a shared writer
+void writeTransaction(JsonWriter& out, const Transaction& t) {
+    out.raw("{\"id\":").string(t.id)
+       .raw(",\"type\":").string(t.type)
+       .raw(",\"amount\":").number(t.amount)
+       .raw(",\"category\":").string(t.category)
+       .raw(",\"description\":").string(t.description)
+       .raw(",\"date\":").string(t.date)
+       .raw('}');
+}
+
+void writeBudget(JsonWriter& out, const Budget& b) {
+    out.raw("{\"category\":").string(b.category)
+       .raw(",\"limit\":").number(b.limit)
+       .raw(",\"spent\":").number(b.spent)
+       .raw(",\"percentUsed\":").number(b.getPercentUsed())
+       .raw(",\"alertLevel\":").string(b.getAlertLevel())
+       .raw('}');
+}
+
+void writeBill(JsonWriter& out, const Bill& b) {
+    out.raw("{\"id\":").string(b.id)
+       .raw(",\"name\":").string(b.name)
+       .raw(",\"amount\":").number(b.amount)
+       .raw(",\"dueDate\":").string(b.dueDate)
+       .raw(",\"category\":").string(b.category)
+       .raw(",\"isPaid\":").boolean(b.isPaid)
+       .raw('}');
+}
+
+void writeAlert(JsonWriter& out, const BudgetAlert& a) {
+    out.raw("{\"category\":").string(a.category)
+       .raw(",\"level\":").string(a.level)
+       .raw(",\"percentUsed\":").number(a.percentUsed)
+       .raw(",\"spent\":").number(a.spent)
+       .raw(",\"limit\":").number(a.limit)
+       .raw(",\"message\":").string(a.message)
+       .raw('}');
+}
+
+void writeCategoryAmount(JsonWriter& out, const CategoryAmount& ca) {
+    out.raw("{\"category\":").string(ca.category)
+       .raw(",\"totalAmount\":").number(ca.totalAmount)
+       .raw('}');
+}
+
+void writeSummary(JsonWriter& out, const MonthlySummary& s) {
+    out.raw("{\"month\":").string(s.month)
+       .raw(",\"totalIncome\":").number(s.totalIncome)
+       .raw(",\"totalExpenses\":").number(s.totalExpenses)
+       .raw(",\"netSavings\":").number(s.netSavings)
+       .raw(",\"transactionCount\":").integer(s.transactionCount)
+       .raw(",\"categoryBreakdown\":[");
+    
+    for (size_t i = 0; i < s.categoryBreakdown.size(); i++) {
+        out.separator(i)
+           .raw("{\"category\":").string(s.categoryBreakdown[i].first)
+           .raw(",\"amount\":").number(s.categoryBreakdown[i].second)
+           .raw('}');
     }
+    
+    out.raw("]}");
 }
 
-double extractDouble(const std::string& json, const std::string& key) {
-    std::string val = extractValue(json, key);
-    if (val.empty()) return 0.0;
-    try {
-        return std::stod(val);
-    } catch (...) {
-        return 0.0;
+// Write a JSON array of records with one of the helpers above
+template<typename T, typename W>
+void writeArray(JsonWriter& out, const std::vector<T>& items, W writeItem) {
+    out.raw('[');
+    for (size_t i = 0; i < items.size(); i++) {
+        out.separator(i);
+        writeItem(out, items[i]);
     }
+    out.raw(']');
 }
 
-int extractInt(const std::string& json, const std::string& key) {
-    std::string val = extractValue(json, key);
-    if (val.empty()) return 0;
-    try {
-        return std::stoi(val);
-    } catch (...) {
-        return 0;
+void writeString(JsonWriter& out, const std::string& s) {
+    out.string(s);
+}
+
+// ===== PAGINATION =====
+// A page cursor travels as an opaque hex token of "date|offset|id"
+
+std::string encodeCursor(const PageCursor& cursor) {
+    static const char hex[] = "0123456789abcdef";
+    std::string plain = cursor.date + "|" + std::to_string(cursor.offset) + "|" + cursor.id;
+    std::string token;
+    token.reserve(plain.size() * 2);
+    for (unsigned char c : plain) {
+        token.push_back(hex[c >> 4]);
+        token.push_back(hex[c & 0xF]);
+    }
+    return token;
+}
+
+bool decodeCursor(const std::string& token, PageCursor& cursor) {
+    if (token.size() % 2 != 0) return false;
+    std::string plain;
+    plain.reserve(token.size() / 2);
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < token.size(); i += 2) {
+        int high = nibble(token[i]);
+        int low = nibble(token[i + 1]);
+        if (high < 0 || low < 0) return false;
+        plain.push_back(static_cast<char>((high << 4) | low));
     }
+    
+    size_t first = plain.find('|');
+    size_t second = first == std::string::npos ? first : plain.find('|', first + 1);
+    if (second == std::string::npos || first == 0) return false;
+    
+    cursor.date = plain.substr(0, first);
+    cursor.id = plain.substr(second + 1);
+    cursor.offset = std::strtoul(plain.c_str() + first + 1, nullptr, 10);
+    return true;
+}
+
+// Write {"transactions":[...],"nextCursor":...} for one page; a page that
+// reaches the end carries "nextCursor":null
+void writeTransactionPage(JsonWriter& out, const TransactionPage& page) {
+    out.raw("{\"transactions\":");
+    writeArray(out, page.transactions, writeTransaction);
+    out.raw(",\"nextCursor\":");
+    if (page.hasMore) out.string(encodeCursor(page.next));
+    else out.raw("null");
+}
+
+// Read the optional "limit"/"cursor" paging parameters. Returns false
+// (after writing the error) when the cursor is malformed.
+bool readPaging(const JsonFields& params, int& limit, PageCursor& cursor, JsonWriter& out) {
+    limit = params.getInt("limit", 0);
+    std::string token = params.getString("cursor");
+    if (!token.empty() && !decodeCursor(token, cursor)) {
+        out.raw("{\"error\":\"Invalid cursor\"}");
+        return false;
+    }
+    return true;
+}
+
+// JSON importers return false when a file does not parse to its end (a
+// missing file is fine: that collection starts empty)
+
+// Import transactions from transactions.json
+bool importTransactionsJson(FinanceEngine& engine, const std::string& dataDir) {
+    std::string content;
+    if (!readFile(dataDir + "/transactions.json", content)) return true;
+    
+    // Scratch buffers for escaped strings, reused across records
+    std::string scratch[5];
+    
+    return forEachJsonRecord(content, "transactions", [&](JsonReader& item) {
+        JsonValue id, type, amount, category, description, date;
+        std::string_view key;
+        while (item.nextKey(key)) {
+            JsonValue value = item.readValue();
+            if (key == "id") id = value;
+            else if (key == "type") type = value;
+            else if (key == "amount") amount = value;
+            else if (key == "category") category = value;
+            else if (key == "description") description = value;
+            else if (key == "date") date = value;
+        }
+        
+        if (!id.empty() && !type.empty()) {
+            engine.loadTransaction(id.text(scratch[0]), type.text(scratch[1]), amount.number(),
+                                   category.text(scratch[2]), description.text(scratch[3]),
+                                   date.text(scratch[4]));
+        }
+    });
 }
 
-bool extractBool(const std::string& json, const std::string& key) {
-    std::string val = extractValue(json, key);
-    return val == "true";
+// Import budgets from budgets.json (spent is recomputed from transactions)
+bool importBudgetsJson(FinanceEngine& engine, const std::string& dataDir) {
+    std::string content;
+    if (!readFile(dataDir + "/budgets.json", content)) return true;
+    
+    std::string scratch;
+    
+    return forEachJsonRecord(content, "budgets", [&](JsonReader& item) {
+        JsonValue category, limit;
+        std::string_view key;
+        while (item.nextKey(key)) {
+            JsonValue value = item.readValue();
+            if (key == "category") category = value;
+            else if (key == "limit") limit = value;
+        }
+        
+        if (!category.empty() && limit.number() > 0) {
+            engine.loadBudget(category.text(scratch), limit.number());
+        }
+    });
 }
 
-std::vector<std::string> splitJsonArray(const std::string& arr) {
-    std::vector<std::string> result;
-    if (arr.length() < 2) return result;
+// Import bills from bills.json
+bool importBillsJson(FinanceEngine& engine, const std::string& dataDir) {
+    std::string content;
+    if (!readFile(dataDir + "/bills.json", content)) return true;
     
-    std::string content = arr.substr(1, arr.length() - 2);  // Remove [ ]
+    std::string scratch[4];
     
-    int depth = 0;
-    size_t start = 0;
+    return forEachJsonRecord(content, "bills", [&](JsonReader& item) {
+        JsonValue id, name, amount, dueDate, category, isPaid;
+        std::string_view key;
+        while (item.nextKey(key)) {
+            JsonValue value = item.readValue();
+            if (key == "id") id = value;
+            else if (key == "name") name = value;
+            else if (key == "amount") amount = value;
+            else if (key == "dueDate") dueDate = value;
+            else if (key == "category") category = value;
+            else if (key == "isPaid") isPaid = value;
+        }
+        
+        if (!id.empty() && !name.empty()) {
+            engine.loadBill(id.text(scratch[0]), name.text(scratch[1]), amount.number(),
+                            dueDate.text(scratch[2]), category.text(scratch[3]), isPaid.boolean());
+        }
+    });
+}
+
+// Import the undo stack from undo_stack.json
+bool importUndoJson(FinanceEngine& engine, const std::string& dataDir) {
+    std::string content;
+    if (!readFile(dataDir + "/undo_stack.json", content)) return true;
     
-    for (size_t i = 0; i < content.length(); i++) {
-        if (content[i] == '{') depth++;
-        else if (content[i] == '}') depth--;
-        else if (content[i] == ',' && depth == 0) {
-            result.push_back(trim(content.substr(start, i - start)));
-            start = i + 1;
+    std::vector<Action> actions;
+    bool parsed = forEachJsonRecord(content, "actions", [&](JsonReader& item) {
+        Action action;
+        std::string_view key;
+        while (item.nextKey(key)) {
+            JsonValue value = item.readValue();
+            if (key == "type") action.type = static_cast<ActionType>(value.integer());
+            else if (key == "data") action.data = value.str();
         }
+        actions.push_back(action);
+    });
+    
+    if (!parsed) return false;
+    
+    // Load in reverse order since we're pushing to stack
+    for (size_t i = actions.size(); i-- > 0; ) {
+        engine.loadUndoAction(actions[i].type, actions[i].data);
     }
+    return true;
+}
+
+// Stream {"<key>":[...]} into a temporary file, draining the writer chunk by
+// chunk, and rename it over path once it is complete and synced
+template<typename T, typename W>
+bool exportCollection(JsonWriter& out, const std::string& path, const char* key,
+                      const std::vector<T>& items, W writeItem) {
+    TraceSpan span("file", "export_json", path);
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
     
-    if (start < content.length()) {
-        result.push_back(trim(content.substr(start)));
+    out.clear();
+    out.setSink(file);
+    out.raw("{\"").raw(key).raw("\":[");
+    bool ok = true;
+    for (size_t i = 0; i < items.size() && ok; i++) {
+        out.separator(i);
+        writeItem(out, items[i]);
+        ok = out.drain();
+    }
+    out.raw("]}");
+    ok = out.flushTo(file) && ok;
+    out.setSink(nullptr);
+    ok = syncFile(file) && ok;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
     }
+    return replaceFile(tmpPath, path);
+}
+
+// Export all collections as JSON files (for import/export; not the hot path).
+// Each file is replaced atomically; returns false if any could not be.
+bool exportJson(const FinanceEngine& engine, const std::string& dataDir) {
+    JsonWriter out;
+    bool ok = true;
+    
+    ok = exportCollection(out, dataDir + "/transactions.json", "transactions",
+                     engine.getAllTransactions(), writeTransaction) && ok;
+    
+    // Budgets keep only their limits; spent is recomputed on import
+    ok = exportCollection(out, dataDir + "/budgets.json", "budgets", engine.getAllBudgets(),
+                     [](JsonWriter& w, const Budget& b) {
+        w.raw("{\"category\":").string(b.category).raw(",\"limit\":").number(b.limit).raw('}');
+    }) && ok;
+    
+    ok = exportCollection(out, dataDir + "/bills.json", "bills", engine.getAllBills(), writeBill) && ok;
+    
+    ok = exportCollection(out, dataDir + "/undo_stack.json", "actions", engine.getUndoActions(),
+                     [](JsonWriter& w, const Action& a) {
+        w.raw("{\"type\":").integer(a.type).raw(",\"data\":").string(a.data).raw('}');
+    }) && ok;
+    return ok;
+}
+
+// ===== PHASES =====
+// Latency of the stages a request can pass through besides its handler;
+// get_metrics reports them with the per-command and per-structure
+// histograms (see METRICS)
+
+enum Phase {
+    PHASE_LOAD,          // loadData: manifest, snapshots the log needs, replay
+    PHASE_LAZY_LOAD,     // ensureLoaded: snapshots loaded on first use
+    PHASE_JSON_IMPORT,   // importAllJson
+    PHASE_LOCK_WAIT,     // waiting for a tenant lock
+    PHASE_COMMIT,        // log append + fsync (commitMutations)
+    PHASE_DURABLE_WAIT,  // group commit: waiting for the flusher's fsync
+    PHASE_CHECKPOINT,    // saveData
+    PHASE_PUBLISH,       // copying an engine version for long reads
+    PHASE_COUNT
+};
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "load", "lazy_load", "json_import", "lock_wait", "commit", "durable_wait", "checkpoint", "publish"
+};
+
+LatencyHistogram phaseLatency[PHASE_COUNT];
+
+// Times a phase into its histogram and, when tracing, records it as a span
+class PhaseScope {
+private:
+    ScopedTimer timer;
+    TraceSpan span;
     
-    return result;
+public:
+    explicit PhaseScope(Phase phase) : timer(phaseLatency[phase]), span("phase", PHASE_NAMES[phase]) {}
+};
+
+// ===== PERSISTENCE =====
+// State = snapshot files named by the manifest + the write-ahead log of
+// mutations made since. A command appends its mutations to the log (O(1) in
+// history size); a checkpoint folds the log into fresh snapshots once the
+// log outgrows them, which keeps the amortized cost per mutation constant.
+// Recovery loads the snapshots and replays only the records after their
+// sequence, so the log size bounds the replay work at startup.
+
+const size_t WAL_MIN_CHECKPOINT_BYTES = 1 << 20;
+
+// --checkpoint-mb: checkpoint once the log passes this size, a fixed bound
+// on replay; 0 = once it outgrows the snapshots
+size_t checkpointBytes = 0;
+
+size_t checkpointThreshold(const SnapshotManifest& manifest) {
+    if (checkpointBytes > 0) return checkpointBytes;
+    return std::max<size_t>(WAL_MIN_CHECKPOINT_BYTES, manifest.snapshotBytes);
 }
 
-// JSON output helpers
-std::string escapeJson(const std::string& str) {
-    std::string result;
-    for (char c : str) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c;
+// Memory held by engine versions across tenants. It is charged against the
+// memory budget apart from the tenants themselves (see releaseTenant).
+std::atomic<size_t> versionBytes(0);
+
+// An immutable copy of a tenant's engine that long reads run on (see
+// withSnapshot) while writers keep changing the tenant's own engine
+struct EngineVersion {
+    FinanceEngine engine;
+    uint64_t version;       // engine.getVersion() when copied
+    unsigned loaded;        // collections that were in memory
+    uint64_t logPosition;   // Tenant::versionLogEnd when copied
+    size_t bytes;           // charged to versionBytes
+    
+    EngineVersion(const FinanceEngine& source, unsigned loadedCollections, uint64_t position)
+        : engine(source), version(source.getVersion()), loaded(loadedCollections),
+          logPosition(position), bytes(source.approximateMemoryBytes()) {
+        versionBytes += bytes;
+    }
+    
+    ~EngineVersion() {
+        versionBytes -= bytes;
+    }
+};
+
+// Frees superseded versions once no reader can still be on them
+EpochManager versionEpochs;
+
+// Group-commit thread (--commit-window-ms); null = each commit fsyncs inline
+std::unique_ptr<WalFlusher> walFlusher;
+
+// One data directory's resident state: its engine plus the snapshot and
+// log bookkeeping that persists it. The daemon keeps many (see TENANTS).
+struct Tenant {
+    std::string dataDir;
+    FinanceEngine engine;
+    WalWriter wal;
+    SnapshotManifest manifest;
+    
+    // Engine generation of each collection when its manifest file was written
+    uint64_t snapshotGenerations[COLLECTION_COUNT];
+    
+    // Collections in memory (MASK_* bits). The rest stay on disk until a
+    // command needs them; a collection that was never loaded was never changed.
+    unsigned loadedCollections;
+    
+    // Readers share the tenant; mutations and lazy loads hold it alone
+    std::shared_mutex lock;
+    
+    // Requests using the tenant right now (guarded by tenantsMutex); a
+    // pinned tenant is never evicted
+    int pins;
+    
+    // False for a named tenant that was never written: it has no directory
+    // yet, and its first logged mutation creates one (see commitMutations)
+    bool onDisk;
+    
+    // Set while the first request loads the tenant outside tenantsMutex
+    // (guarded by tenantsMutex); other requests wait for it on tenantsChanged
+    bool loading;
+    
+    // Engine memory estimate and version, taken whenever the engine last
+    // changed; readable without the lock
+    std::atomic<size_t> approximateBytes;
+    std::atomic<uint64_t> committedVersion;
+    
+    // Latest version published for long reads (nullptr until one is needed)
+    std::atomic<EngineVersion*> published;
+    std::mutex publishMutex;  // one reader publishes at a time
+    
+    // The version published before, kept to be brought up to date and
+    // published again once no reader can be on it (guarded by publishMutex)
+    EngineVersion* spare;
+    uint64_t spareEpoch;  // versionEpochs.unpublish() when it was replaced
+    
+    // Mutations committed since the spare's version, so it catches up by
+    // replaying them instead of copying the whole engine. Appended under the
+    // exclusive lock once a version exists; read and trimmed by the publisher
+    // under the shared lock. versionLogEnd counts every mutation ever appended.
+    std::deque<Mutation> versionLog;
+    uint64_t versionLogEnd;
+    bool keepVersionLog;
+    
+    explicit Tenant(const std::string& dir)
+        : dataDir(dir), loadedCollections(0), pins(0), onDisk(true), loading(false), approximateBytes(0),
+          committedVersion(0), published(nullptr), spare(nullptr), spareEpoch(0),
+          versionLogEnd(0), keepVersionLog(false) {
+        for (int i = 0; i < COLLECTION_COUNT; i++) snapshotGenerations[i] = 0;
+        wal.useFlusher(walFlusher.get());
+    }
+    
+    // Only unpinned tenants are destroyed, so no reader is on the versions
+    ~Tenant() {
+        delete published.load();
+        delete spare;
+    }
+    
+    // Refresh the lock-free copies of the engine's state; called by whoever
+    // holds the tenant exclusively, after changing it
+    void noteEngineChanged() {
+        approximateBytes = engine.approximateMemoryBytes();
+        committedVersion = engine.getVersion();
+    }
+};
+
+std::string walPath(const std::string& dataDir) {
+    return dataDir + "/engine.wal";
+}
+
+typedef size_t (*SnapshotSaver)(const FinanceEngine&, const std::string&);
+typedef SnapshotStatus (*SnapshotLoader)(FinanceEngine&, const std::string&);
+typedef bool (*JsonImporter)(FinanceEngine&, const std::string&);
+
+const SnapshotSaver snapshotSavers[COLLECTION_COUNT] = {
+    saveTransactionsSnapshot, saveBudgetsSnapshot, saveBillsSnapshot, saveUndoSnapshot
+};
+const SnapshotLoader snapshotLoaders[COLLECTION_COUNT] = {
+    loadTransactionsSnapshot, loadBudgetsSnapshot, loadBillsSnapshot, loadUndoSnapshot
+};
+const JsonImporter jsonImporters[COLLECTION_COUNT] = {
+    importTransactionsJson, importBudgetsJson, importBillsJson, importUndoJson
+};
+
+// Checkpoint: write a new snapshot of each collection that changed since
+// its last one (unchanged files carry over), switch the manifest over to
+// them, then empty the log and delete the superseded files. Returns false
+// when the checkpoint could not be completed (the previous one stays).
+bool saveData(Tenant& tenant) {
+    PhaseScope timer(PHASE_CHECKPOINT);
+    const std::string& dataDir = tenant.dataDir;
+    SnapshotManifest next = tenant.manifest;
+    next.sequence = tenant.wal.lastSequence();
+    next.snapshotBytes = 0;
+    uint64_t written[COLLECTION_COUNT];
+    
+    for (int i = 0; i < COLLECTION_COUNT; i++) {
+        written[i] = tenant.engine.getGeneration(static_cast<Collection>(i));
+        bool loaded = (tenant.loadedCollections & (1u << i)) != 0;
+        if (!tenant.manifest.files[i].empty() && (!loaded || written[i] == tenant.snapshotGenerations[i])) {
+            next.snapshotBytes += next.fileBytes[i];
+            continue;
+        }
+        
+        next.files[i] = snapshotFileName(i, next.sequence);
+        {
+            TraceSpan span("file", "save_snapshot", next.files[i]);
+            next.fileBytes[i] = snapshotSavers[i](tenant.engine, dataDir + "/" + next.files[i]);
+        }
+        if (next.fileBytes[i] == 0) {
+            std::cerr << "Warning: failed to write snapshot " << next.files[i] << std::endl;
+            return false;  // keep the previous checkpoint and the log
         }
+        next.snapshotBytes += next.fileBytes[i];
+    }
+    
+    bool manifestWritten;
+    {
+        TraceSpan span("file", "write_manifest", dataDir);
+        manifestWritten = writeManifest(dataDir, next);
+    }
+    if (!manifestWritten) {
+        std::cerr << "Warning: failed to write snapshot manifest in " << dataDir << std::endl;
+        return false;
+    }
+    
+    // The manifest covers every mutation now; a log that cannot be reopened
+    // fails the next commit, which checkpoints again
+    if (!tenant.wal.reset()) {
+        std::cerr << "Warning: failed to reset " << walPath(dataDir) << std::endl;
+    }
+    for (int i = 0; i < COLLECTION_COUNT; i++) {
+        if (!tenant.manifest.files[i].empty() && tenant.manifest.files[i] != next.files[i]) {
+            std::remove((dataDir + "/" + tenant.manifest.files[i]).c_str());
+        }
+        tenant.snapshotGenerations[i] = written[i];
+    }
+    tenant.manifest = next;
+    return true;
+}
+
+// A log write failed (or the log is not open): the mutations are applied in
+// memory but not durable. A checkpoint makes them durable anyway; when that
+// fails too the request must fail rather than be acknowledged.
+void checkpointAfterLogFailure(Tenant& tenant) {
+    std::cerr << "Warning: failed to write " << walPath(tenant.dataDir) << "; checkpointing instead" << std::endl;
+    if (!saveData(tenant)) {
+        throw std::runtime_error("Could not make the change durable: writing " + walPath(tenant.dataDir) +
+                                 " and checkpointing both failed (the change is applied in memory only)");
     }
-    return result;
 }
 
-std::string transactionToJson(const Transaction& t) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"id\":\"" << escapeJson(t.id) << "\","
-       << "\"type\":\"" << escapeJson(t.type) << "\","
-       << "\"amount\":" << t.amount << ","
-       << "\"category\":\"" << escapeJson(t.category) << "\","
-       << "\"description\":\"" << escapeJson(t.description) << "\","
-       << "\"date\":\"" << escapeJson(t.date) << "\"}";
-    return ss.str();
+// Most mutations kept for a spare version; past that a full copy is cheaper
+// than the replay, and the log stops growing when long reads stop
+const size_t VERSION_LOG_LIMIT = 1 << 16;
+
+// Keep committed mutations for the next version (see withSnapshot)
+void recordVersionLog(Tenant& tenant, const std::vector<Mutation>& mutations) {
+    tenant.versionLogEnd += mutations.size();
+    if (!tenant.keepVersionLog) return;
+    if (tenant.versionLog.size() + mutations.size() > VERSION_LOG_LIMIT) {
+        tenant.versionLog.clear();  // the spare falls back to a full copy
+        return;
+    }
+    tenant.versionLog.insert(tenant.versionLog.end(), mutations.begin(), mutations.end());
 }
 
-std::string budgetToJson(const Budget& b) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"category\":\"" << escapeJson(b.category) << "\","
-       << "\"limit\":" << b.limit << ","
-       << "\"spent\":" << b.spent << ","
-       << "\"percentUsed\":" << b.getPercentUsed() << ","
-       << "\"alertLevel\":\"" << b.getAlertLevel() << "\"}";
-    return ss.str();
+// Append the mutations of the last command(s) to the log and fsync once;
+// checkpoint when the log has grown past its threshold or a command asked
+// for it. With group commit the fsync happens on the flusher thread: returns
+// the sequence to wait for (see WalWriter::waitDurable), or 0 when nothing
+// is pending. Throws when the mutations cannot be made durable.
+uint64_t commitMutations(Tenant& tenant) {
+    std::vector<Mutation> mutations = tenant.engine.takeMutations();
+    bool requested = tenant.engine.takeCheckpointRequest();
+    if (mutations.empty() && (!requested || !tenant.onDisk)) return 0;
+    
+    if (!tenant.onDisk) {
+        if (!ensureDirectory(tenant.dataDir) || !tenant.wal.open(walPath(tenant.dataDir), 1, 0)) {
+            throw std::runtime_error("Cannot create tenant directory " + tenant.dataDir +
+                                     " (the change is applied in memory only)");
+        }
+        tenant.onDisk = true;
+    }
+    if (!mutations.empty()) {
+        recordVersionLog(tenant, mutations);
+        PhaseScope timer(PHASE_COMMIT);
+        for (const auto& m : mutations) {
+            tenant.wal.append(m);
+        }
+        if (!tenant.wal.sync()) {
+            checkpointAfterLogFailure(tenant);
+            return 0;
+        }
+    }
+    
+    if (requested || tenant.wal.size() > checkpointThreshold(tenant.manifest)) {
+        // The snapshots make everything durable; if they fail, the log already has it
+        if (!saveData(tenant) && tenant.wal.hasFailed()) checkpointAfterLogFailure(tenant);
+        return 0;
+    }
+    return walFlusher ? tenant.wal.lastSequence() : 0;
 }
 
-std::string billToJson(const Bill& b) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"id\":\"" << escapeJson(b.id) << "\","
-       << "\"name\":\"" << escapeJson(b.name) << "\","
-       << "\"amount\":" << b.amount << ","
-       << "\"dueDate\":\"" << escapeJson(b.dueDate) << "\","
-       << "\"category\":\"" << escapeJson(b.category) << "\","
-       << "\"isPaid\":" << (b.isPaid ? "true" : "false") << "}";
-    return ss.str();
+// Load the snapshots of the collections in mask that are not in memory yet
+SnapshotStatus loadSnapshots(Tenant& tenant, unsigned mask) {
+    for (int i = 0; i < COLLECTION_COUNT; i++) {
+        unsigned bit = 1u << i;
+        if (!(mask & bit) || (tenant.loadedCollections & bit)) continue;
+        
+        TraceSpan span("file", "load_snapshot", tenant.manifest.files[i]);
+        SnapshotStatus status = snapshotLoaders[i](tenant.engine, tenant.dataDir + "/" + tenant.manifest.files[i]);
+        if (status != SNAPSHOT_OK) return status;
+        tenant.loadedCollections |= bit;
+        tenant.snapshotGenerations[i] = tenant.engine.getGeneration(static_cast<Collection>(i));
+    }
+    return SNAPSHOT_OK;
 }
 
-std::string alertToJson(const BudgetAlert& a) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"category\":\"" << escapeJson(a.category) << "\","
-       << "\"level\":\"" << escapeJson(a.level) << "\","
-       << "\"percentUsed\":" << a.percentUsed << ","
-       << "\"spent\":" << a.spent << ","
-       << "\"limit\":" << a.limit << ","
-       << "\"message\":\"" << escapeJson(a.message) << "\"}";
-    return ss.str();
+// A data file that failed verification. Startup and one-shot runs print it
+// and exit 1; a resident engine answers the request with it.
+class DamagedData : public std::runtime_error {
+public:
+    explicit DamagedData(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Rebuild everything from the JSON files (no checkpoint yet, or
+// --import-json). A file that stops parsing midway fails the load: its
+// records up to the damage would otherwise be checkpointed as the ledger.
+void importAllJson(Tenant& tenant) {
+    PhaseScope timer(PHASE_JSON_IMPORT);
+    tenant.engine.clearAll();
+    tenant.manifest = SnapshotManifest();
+    for (int i = 0; i < COLLECTION_COUNT; i++) {
+        TraceSpan span("file", "import_json", COLLECTION_NAMES[i]);
+        if (!jsonImporters[i](tenant.engine, tenant.dataDir)) {
+            tenant.engine.clearAll();
+            throw DamagedData("Malformed " + tenant.dataDir + "/" + COLLECTION_NAMES[i] +
+                              ".json (truncated or invalid JSON)");
+        }
+    }
+    tenant.loadedCollections = MASK_ALL;
 }
 
-std::string categoryAmountToJson(const CategoryAmount& ca) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"category\":\"" << escapeJson(ca.category) << "\","
-       << "\"totalAmount\":" << ca.totalAmount << "}";
-    return ss.str();
+// A checkpoint that fails verification is not replaced by older data: the
+// JSON files lag the snapshots, so falling back would lose history quietly
+DamagedData damagedCheckpoint(const std::string& dataDir) {
+    return DamagedData("Damaged checkpoint in " + dataDir +
+                       " (snapshot missing or checksum mismatch); restore the directory from a backup");
 }
 
-std::string summaryToJson(const MonthlySummary& s) {
-    std::ostringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    ss << "{\"month\":\"" << escapeJson(s.month) << "\","
-       << "\"totalIncome\":" << s.totalIncome << ","
-       << "\"totalExpenses\":" << s.totalExpenses << ","
-       << "\"netSavings\":" << s.netSavings << ","
-       << "\"transactionCount\":" << s.transactionCount << ","
-       << "\"categoryBreakdown\":[";
+// --salvage-log: load a damaged log up to the damage instead of failing
+bool salvageLog = false;
+
+// Read the log; damage before its end fails the load (see readWal). When
+// salvaging, the records before the damage are kept, the log is saved as
+// engine.wal.damaged, and the rest is cut off when the log is opened.
+void readLog(const Tenant& tenant, std::vector<WalEntry>& entries, size_t& validBytes) {
+    TraceSpan span("file", "read_wal", tenant.dataDir);
+    std::string path = walPath(tenant.dataDir);
+    if (readWal(path, entries, validBytes) != WAL_CORRUPT) return;
     
-    for (size_t i = 0; i < s.categoryBreakdown.size(); i++) {
-        if (i > 0) ss << ",";
-        ss << "{\"category\":\"" << escapeJson(s.categoryBreakdown[i].first) << "\","
-           << "\"amount\":" << s.categoryBreakdown[i].second << "}";
+    if (!salvageLog) {
+        throw DamagedData("Damaged log " + path + " (intact records after a bad one); restore it from a "
+                          "backup, or start once with --salvage-log to keep the records before the damage");
     }
-    
-    ss << "]}";
-    return ss.str();
+    std::string damaged;
+    if (!readFile(path, damaged) || !writeFileAtomic(path + ".damaged", damaged)) {
+        throw DamagedData("Damaged log " + path + " could not be saved to " + path + ".damaged; not salvaging");
+    }
+    std::cerr << "Warning: salvaged " << path << ": kept " << entries.size()
+              << " records before the damage; the whole log is saved as " << path << ".damaged" << std::endl;
 }
 
-// Global finance engine instance
-FinanceEngine engine;
+// Before --import-json replaces the state: the checkpoint it supersedes, the
+// log's current size, and a sequence past everything either holds. The
+// import is checkpointed under that sequence, so its snapshots never
+// overwrite a file the current manifest names, and log records left over
+// from a failed reset are never replayed over it.
+uint64_t prepareImport(const Tenant& tenant, SnapshotManifest& superseded, size_t& logBytes) {
+    if (readManifest(tenant.dataDir, superseded) != SNAPSHOT_OK) {
+        superseded = SnapshotManifest();  // none, or damaged: no files to supersede
+    }
+    uint64_t sequence = superseded.sequence;
+    std::vector<WalEntry> entries;
+    size_t validBytes;
+    readWal(walPath(tenant.dataDir), entries, validBytes);
+    for (const auto& entry : entries) sequence = std::max(sequence, entry.sequence);
+    
+    std::string log;
+    logBytes = readFile(walPath(tenant.dataDir), log) ? log.size() : 0;
+    return sequence + 1;
+}
 
-// Load data from files
-void loadData(const std::string& dataDir) {
-    // Load transactions
-    std::ifstream transFile(dataDir + "/transactions.json");
-    if (transFile.is_open()) {
-        std::stringstream buffer;
-        buffer << transFile.rdbuf();
-        std::string content = buffer.str();
-        transFile.close();
+// Load data from files: the manifest plus only the snapshots the log tail
+// touches (the rest load on demand, see ensureLoaded), or a one-time JSON
+// import when there is no checkpoint yet. Every file is verified before it
+// is used; damage throws std::runtime_error and leaves the files untouched.
+void loadData(Tenant& tenant, bool preferJson = false) {
+    PhaseScope timer(PHASE_LOAD);
+    const std::string& dataDir = tenant.dataDir;
+    bool imported = preferJson;
+    
+    // A JSON import replaces the state, so it drops the log, but only once
+    // the imported state is checkpointed
+    std::vector<WalEntry> entries;
+    size_t validBytes = 0;
+    uint64_t importSequence = 0;
+    SnapshotManifest superseded;
+    if (preferJson) {
+        importSequence = prepareImport(tenant, superseded, validBytes);
+    } else {
+        readLog(tenant, entries, validBytes);
         
-        std::string arr = extractValue(content, "transactions");
-        if (!arr.empty()) {
-            auto items = splitJsonArray(arr);
-            for (const auto& item : items) {
-                std::string id = extractValue(item, "id");
-                std::string type = extractValue(item, "type");
-                double amount = extractDouble(item, "amount");
-                std::string category = extractValue(item, "category");
-                std::string description = extractValue(item, "description");
-                std::string date = extractValue(item, "date");
-                
-                if (!id.empty() && !type.empty()) {
-                    engine.loadTransaction(id, type, amount, category, description, date);
+        SnapshotStatus status;
+        {
+            TraceSpan span("file", "read_manifest", dataDir);
+            status = readManifest(dataDir, tenant.manifest);
+        }
+        if (status == SNAPSHOT_MISSING) {
+            imported = true;  // first run
+        } else {
+            if (status == SNAPSHOT_OK) {
+                unsigned needed = 0;
+                for (const auto& entry : entries) {
+                    if (entry.sequence > tenant.manifest.sequence) needed |= mutationCollections(entry.mutation.type);
                 }
+                status = loadSnapshots(tenant, needed);
             }
+            if (status != SNAPSHOT_OK) throw damagedCheckpoint(dataDir);
         }
     }
     
-    // Load budgets
-    std::ifstream budgetFile(dataDir + "/budgets.json");
-    if (budgetFile.is_open()) {
-        std::stringstream buffer;
-        buffer << budgetFile.rdbuf();
-        std::string content = buffer.str();
-        budgetFile.close();
-        
-        std::string arr = extractValue(content, "budgets");
-        if (!arr.empty()) {
-            auto items = splitJsonArray(arr);
-            for (const auto& item : items) {
-                std::string category = extractValue(item, "category");
-                double limit = extractDouble(item, "limit");
-                
-                if (!category.empty() && limit > 0) {
-                    engine.loadBudget(category, limit);
-                }
+    if (imported) {
+        importAllJson(tenant);
+    }
+    if (preferJson) {
+        tenant.manifest = superseded;  // its files are deleted by the checkpoint below
+    }
+    
+    // Replay the log tail
+    uint64_t lastSequence = preferJson ? importSequence : tenant.manifest.sequence;
+    for (const auto& entry : entries) {
+        if (entry.sequence <= tenant.manifest.sequence) continue;
+        tenant.engine.applyMutation(entry.mutation);
+        lastSequence = entry.sequence;
+    }
+    
+    // Without the log no mutation could be made durable
+    if (!tenant.wal.open(walPath(tenant.dataDir), lastSequence + 1, validBytes)) {
+        throw std::runtime_error("Cannot open log " + walPath(tenant.dataDir));
+    }
+    
+    // Convert once, so later startups skip JSON parsing entirely. Until
+    // this checkpoint switches the manifest, the previous one and its log
+    // are untouched, so a failed --import-json loses nothing.
+    if (imported && !saveData(tenant) && preferJson) {
+        throw std::runtime_error("Could not checkpoint the JSON import in " + dataDir +
+                                 "; the previous checkpoint and log are unchanged");
+    }
+}
+
+// Make sure the collections in mask are in memory before a command runs.
+// A snapshot found damaged this late fails the command the same way; the
+// collections already loaded stay as they are.
+void ensureLoaded(Tenant& tenant, unsigned mask) {
+    if ((mask & ~tenant.loadedCollections) == 0) return;
+    
+    PhaseScope timer(PHASE_LAZY_LOAD);
+    if (loadSnapshots(tenant, mask) != SNAPSHOT_OK) {
+        throw damagedCheckpoint(tenant.dataDir);
+    }
+}
+
+// NDJSON: one transaction per line as the BST walk reaches it, then a
+// {"done":true,"count":N} trailer line. Output drains to the writer's sink
+// chunk by chunk, so memory stays bounded whatever the history size.
+void streamTransactions(FinanceEngine& engine, JsonWriter& out, const std::string* startDate,
+                        const std::string* endDate, bool descending) {
+    long long count = 0;
+    engine.visitTransactions(startDate, endDate, descending, [&](const Transaction& t) {
+        writeTransaction(out, t);
+        out.raw('\n');
+        count++;
+        return out.drain();    // stop early once the reader has gone away
+    });
+    out.raw("{\"done\":true,\"count\":").integer(count).raw('}');
+}
+
+// Current local date in a strftime format. localtime_r/localtime_s, since
+// handlers run on several threads at once.
+std::string formatToday(const char* format) {
+    time_t now = time(0);
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char buffer[16];
+    strftime(buffer, sizeof(buffer), format, &local);
+    return buffer;
+}
+
+// ===== COMMAND HANDLERS =====
+// Each appends its JSON result to out. With stream set, list commands answer
+// in NDJSON instead (see streamTransactions).
+
+void handleAddTransaction(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string type = params.getString("type");
+    double amount = params.getDouble("amount");
+    std::string category = params.getString("category");
+    std::string description = params.getString("description");
+    std::string date = params.getString("date");
+    
+    if (date.empty()) {
+        date = formatToday("%Y-%m-%d");
+    }
+    
+    Transaction t = engine.addTransaction(type, amount, category, description, date);
+    out.raw("{\"success\":true,\"transaction\":");
+    writeTransaction(out, t);
+    out.raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleDeleteTransaction(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string id = params.getString("id");
+    bool success = engine.deleteTransaction(id);
+    out.raw("{\"success\":").boolean(success)
+       .raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleGetTransactions(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool stream) {
+    if (stream) {
+        streamTransactions(engine, out, nullptr, nullptr, true);
+        return;
+    }
+    
+    // With a limit: newest first, one page per call
+    int limit;
+    PageCursor cursor;
+    if (!readPaging(params, limit, cursor, out)) return;
+    if (limit > 0) {
+        writeTransactionPage(out, engine.getTransactionPage(nullptr, nullptr, true, cursor, limit));
+        out.raw('}');
+        return;
+    }
+    
+    auto transactions = engine.getTransactionsByDateDesc();
+    out.raw("{\"transactions\":");
+    writeArray(out, transactions, writeTransaction);
+    out.raw('}');
+}
+
+void handleGetRecentTransactions(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    int count = params.getInt("count", 10);
+    auto transactions = engine.getRecentTransactions(count);
+    out.raw("{\"transactions\":");
+    writeArray(out, transactions, writeTransaction);
+    out.raw(",\"dsInfo\":\"Recent transactions from Stack (LIFO)\"}");
+}
+
+void handleGetTransactionsByDate(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool stream) {
+    std::string startDate = params.getString("startDate");
+    std::string endDate = params.getString("endDate");
+    if (stream) {
+        streamTransactions(engine, out, &startDate, &endDate, false);
+        return;
+    }
+    
+    int limit;
+    PageCursor cursor;
+    if (!readPaging(params, limit, cursor, out)) return;
+    if (limit > 0) {
+        writeTransactionPage(out, engine.getTransactionPage(&startDate, &endDate, false, cursor, limit));
+        out.raw(",\"dsInfo\":\"Date range query using BST\"}");
+        return;
+    }
+    
+    auto transactions = engine.getTransactionsInRange(startDate, endDate);
+    out.raw("{\"transactions\":");
+    writeArray(out, transactions, writeTransaction);
+    out.raw(",\"dsInfo\":\"Date range query using BST\"}");
+}
+
+void handleSetBudget(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string category = params.getString("category");
+    double limit = params.getDouble("limit");
+    engine.setBudget(category, limit);
+    Budget b;
+    engine.getBudget(category, b);
+    out.raw("{\"success\":true,\"budget\":");
+    writeBudget(out, b);
+    out.raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleGetBudgets(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    auto budgets = engine.getAllBudgets();
+    out.raw("{\"budgets\":");
+    writeArray(out, budgets, writeBudget);
+    out.raw(",\"dsInfo\":\"Budget data stored in HashMap\"}");
+}
+
+void handleGetAlerts(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    auto alerts = engine.getBudgetAlerts();
+    out.raw("{\"alerts\":");
+    writeArray(out, alerts, writeAlert);
+    out.raw('}');
+}
+
+void handleAddBill(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string name = params.getString("name");
+    double amount = params.getDouble("amount");
+    std::string dueDate = params.getString("dueDate");
+    std::string category = params.getString("category");
+    
+    Bill b = engine.addBill(name, amount, dueDate, category);
+    out.raw("{\"success\":true,\"bill\":");
+    writeBill(out, b);
+    out.raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleGetBills(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    auto bills = engine.getAllBills();
+    out.raw("{\"bills\":");
+    writeArray(out, bills, writeBill);
+    out.raw(",\"dsInfo\":\"Bills managed in Queue (FIFO)\"}");
+}
+
+void handlePayBill(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string id = params.getString("id");
+    bool success = engine.payBill(id);
+    out.raw("{\"success\":").boolean(success)
+       .raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleDeleteBill(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string id = params.getString("id");
+    bool success = engine.removeBill(id);
+    out.raw("{\"success\":").boolean(success)
+       .raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleGetTopExpenses(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    int k = params.getInt("count", 5);
+    auto expenses = engine.getTopExpenses(k);
+    out.raw("{\"topExpenses\":");
+    writeArray(out, expenses, writeTransaction);
+    out.raw(",\"dsInfo\":\"Top expenses extracted from Max Heap\"}");
+}
+
+void handleGetTopCategories(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    int k = params.getInt("count", 5);
+    auto categories = engine.getTopCategories(k);
+    out.raw("{\"topCategories\":");
+    writeArray(out, categories, writeCategoryAmount);
+    out.raw(",\"dsInfo\":\"Top categories from Category Max Heap\"}");
+}
+
+void handleGetMonthlySummary(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string month = params.getString("month");
+    if (month.empty()) {
+        month = formatToday("%Y-%m");
+    }
+    MonthlySummary summary = engine.getMonthlySummary(month);
+    out.raw("{\"summary\":");
+    writeSummary(out, summary);
+    out.raw(",\"dsInfo\":\"Monthly data from BST range query\"}");
+}
+
+void handleGetCategorySuggestions(FinanceEngine& engine, const JsonFields& params, JsonWriter& out, bool) {
+    std::string prefix = params.getString("prefix");
+    auto suggestions = engine.getCategorySuggestions(prefix);
+    out.raw("{\"suggestions\":");
+    writeArray(out, suggestions, writeString);
+    out.raw(",\"dsInfo\":\"Autocomplete using Trie\"}");
+}
+
+void handleGetAllCategories(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    auto categories = engine.getAllCategories();
+    out.raw("{\"categories\":");
+    writeArray(out, categories, writeString);
+    out.raw('}');
+}
+
+void handleUndo(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    bool success = engine.undo();
+    out.raw("{\"success\":").boolean(success)
+       .raw(",\"canUndo\":").boolean(engine.canUndo())
+       .raw(",\"dsInfo\":\"Undo operation using Stack\"}");
+}
+
+void handleGetDashboard(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    out.raw("{\"balance\":").number(engine.getTotalBalance())
+       .raw(",\"totalIncome\":").number(engine.getTotalIncome())
+       .raw(",\"totalExpenses\":").number(engine.getTotalExpenses())
+       .raw(",\"transactionCount\":").integer(engine.getTransactionCount())
+       .raw(",\"budgetCount\":").integer(engine.getBudgetCount())
+       .raw(",\"billCount\":").integer(engine.getBillCount())
+       .raw(",\"canUndo\":").boolean(engine.canUndo()).raw('}');
+}
+
+void handleClearUndo(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    engine.clearUndoStack();
+    out.raw("{\"success\":true,\"canUndo\":false}");
+}
+
+// Fold the log into snapshots now (the commit after the handler does it),
+// e.g. before a planned restart so the next startup replays nothing
+void handleCheckpoint(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    engine.requestCheckpoint();
+    out.raw("{\"success\":true,\"message\":\"Checkpoint written\"}");
+}
+
+void writeHashMapStats(JsonWriter& out, const HashMapStats& s) {
+    out.raw("{\"entries\":").integer(s.entries)
+       .raw(",\"buckets\":").integer(s.buckets)
+       .raw(",\"usedBuckets\":").integer(s.usedBuckets)
+       .raw(",\"loadFactor\":").number(static_cast<double>(s.entries) / s.buckets)
+       .raw(",\"maxChain\":").integer(s.maxChain)
+       .raw(",\"meanProbe\":").number(s.meanProbe)
+       .raw(",\"bytes\":").integer(static_cast<long long>(s.bytes)).raw('}');
+}
+
+void writeContainerStats(JsonWriter& out, const ContainerStats& s) {
+    out.raw("{\"size\":").integer(s.size)
+       .raw(",\"bytes\":").integer(static_cast<long long>(s.bytes)).raw('}');
+}
+
+void writeTrieStats(JsonWriter& out, const TrieStats& s) {
+    out.raw("{\"words\":").integer(s.words)
+       .raw(",\"nodes\":").integer(s.nodes)
+       .raw(",\"deadNodes\":").integer(s.deadNodes)
+       .raw(",\"bytes\":").integer(static_cast<long long>(s.bytes)).raw('}');
+}
+
+// Shape and footprint of each structure of the tenant's engine, plus
+// warnings for any past its threshold (see FinanceEngine::getEngineStats).
+// Byte counts are estimates from object sizes and string capacities;
+// estimatedBytes is the per-record figure the memory budget charges.
+void handleGetEngineStats(FinanceEngine& engine, const JsonFields&, JsonWriter& out, bool) {
+    EngineStats s = engine.getEngineStats();
+    out.raw("{\"budgetMap\":");
+    writeHashMapStats(out, s.budgets);
+    out.raw(",\"expenseMap\":");
+    writeHashMapStats(out, s.expenseTotals);
+    out.raw(",\"transactionList\":");
+    writeContainerStats(out, s.transactionList);
+    out.raw(",\"transactionBST\":{\"nodes\":").integer(s.dateIndex.nodes)
+       .raw(",\"transactions\":").integer(s.dateIndex.transactions)
+       .raw(",\"height\":").integer(s.dateIndex.height)
+       .raw(",\"bytes\":").integer(static_cast<long long>(s.dateIndex.bytes)).raw('}');
+    out.raw(",\"billQueue\":");
+    writeContainerStats(out, s.billQueue);
+    out.raw(",\"undoStack\":");
+    writeContainerStats(out, s.undoStack);
+    out.raw(",\"recentStack\":");
+    writeContainerStats(out, s.recentStack);
+    out.raw(",\"categoryTrie\":");
+    writeTrieStats(out, s.categories);
+    out.raw(",\"payeeTrie\":");
+    writeTrieStats(out, s.payees);
+    out.raw(",\"heaps\":{\"expenseHeapSize\":").integer(s.expenseHeapSize)
+       .raw(",\"categoryHeapSize\":").integer(s.categoryHeapSize)
+       .raw(",\"expenseHeapBytes\":").integer(static_cast<long long>(s.expenseHeapSize * sizeof(Transaction)))
+       .raw('}');
+    out.raw(",\"totalBytes\":").integer(static_cast<long long>(s.totalBytes))
+       .raw(",\"estimatedBytes\":").integer(static_cast<long long>(engine.approximateMemoryBytes()))
+       .raw(",\"warnings\":");
+    writeArray(out, s.warnings, writeString);
+    out.raw('}');
+}
+
+// Defined with the command table's metrics (see METRICS)
+void writeMetrics(JsonWriter& out, bool buckets);
+
+// Latency histograms of the whole process, across tenants; "buckets":true
+// adds each one's non-empty buckets
+void handleGetMetrics(FinanceEngine&, const JsonFields& params, JsonWriter& out, bool) {
+    writeMetrics(out, params.get("buckets").boolean());
+}
+
+// Defined with the command table (see COMMAND TABLE)
+void writeCommandList(JsonWriter& out);
+
+// Every command with how it uses the engine ("read", "snapshot" or "write"),
+// so a client can tell which requests are safe to resend
+void handleListCommands(FinanceEngine&, const JsonFields&, JsonWriter& out, bool) {
+    writeCommandList(out);
+}
+
+// ===== COMMAND TABLE =====
+// One entry per command: its handler plus what dispatch, persistence and
+// lazy loading need to know about it. A perfect hash built at compile time
+// finds the entry in O(1).
+
+typedef void (*CommandHandler)(FinanceEngine&, const JsonFields&, JsonWriter&, bool);
+
+// What a command answers with
+enum ResponseShape {
+    RESPONSE_RESULT,  // {"success":...,"canUndo":...} plus the changed record
+    RESPONSE_OBJECT,  // one summary object
+    RESPONSE_LIST,    // {"<items>":[...]}
+    RESPONSE_PAGED    // a list that also takes limit/cursor and "stream"
+};
+
+// How a command may use its tenant's engine (see withTenant, withSnapshot)
+enum CommandAccess {
+    ACCESS_READ,      // short read under the shared lock
+    ACCESS_SNAPSHOT,  // long read on a published version, blocking no writer
+    ACCESS_WRITE      // may change state (and so append to the log)
+};
+
+struct CommandSpec {
+    std::string_view name;
+    CommandHandler handler;
+    CommandAccess access;
+    unsigned collections;   // what it reads plus what it may change (MASK_*)
+    ResponseShape shape;
+};
+
+constexpr CommandSpec COMMANDS[] = {
+    {"add_transaction",          handleAddTransaction,        ACCESS_WRITE,   MASK_TRANSACTIONS | MASK_BUDGETS | MASK_UNDO, RESPONSE_RESULT},
+    {"delete_transaction",       handleDeleteTransaction,     ACCESS_WRITE,   MASK_TRANSACTIONS | MASK_BUDGETS | MASK_UNDO, RESPONSE_RESULT},
+    {"get_transactions",         handleGetTransactions,       ACCESS_SNAPSHOT, MASK_TRANSACTIONS, RESPONSE_PAGED},
+    {"get_recent_transactions",  handleGetRecentTransactions, ACCESS_READ,    MASK_TRANSACTIONS, RESPONSE_LIST},
+    {"get_transactions_by_date", handleGetTransactionsByDate, ACCESS_SNAPSHOT, MASK_TRANSACTIONS, RESPONSE_PAGED},
+    {"set_budget",               handleSetBudget,             ACCESS_WRITE,   MASK_BUDGETS | MASK_UNDO, RESPONSE_RESULT},
+    // spent comes from the stored totals
+    {"get_budgets",              handleGetBudgets,            ACCESS_READ,    MASK_BUDGETS, RESPONSE_LIST},
+    {"get_alerts",               handleGetAlerts,             ACCESS_READ,    MASK_BUDGETS, RESPONSE_LIST},
+    {"add_bill",                 handleAddBill,               ACCESS_WRITE,   MASK_BILLS | MASK_UNDO, RESPONSE_RESULT},
+    {"get_bills",                handleGetBills,              ACCESS_READ,    MASK_BILLS, RESPONSE_LIST},
+    {"pay_bill",                 handlePayBill,               ACCESS_WRITE,   MASK_BILLS | MASK_UNDO, RESPONSE_RESULT},
+    {"delete_bill",              handleDeleteBill,            ACCESS_WRITE,   MASK_BILLS | MASK_UNDO, RESPONSE_RESULT},
+    {"get_top_expenses",         handleGetTopExpenses,        ACCESS_SNAPSHOT, MASK_TRANSACTIONS, RESPONSE_LIST},
+    {"get_top_categories",       handleGetTopCategories,      ACCESS_READ,    MASK_BUDGETS, RESPONSE_LIST},
+    {"get_monthly_summary",      handleGetMonthlySummary,     ACCESS_SNAPSHOT, MASK_TRANSACTIONS, RESPONSE_OBJECT},
+    // category names are saved with budgets
+    {"get_category_suggestions", handleGetCategorySuggestions, ACCESS_READ,    MASK_BUDGETS, RESPONSE_LIST},
+    {"get_all_categories",       handleGetAllCategories,      ACCESS_READ,    MASK_BUDGETS, RESPONSE_LIST},
+    {"undo",                     handleUndo,                  ACCESS_WRITE,   MASK_ALL, RESPONSE_RESULT},
+    {"get_dashboard",            handleGetDashboard,          ACCESS_READ,    MASK_ALL, RESPONSE_OBJECT},
+    {"clear_undo",               handleClearUndo,             ACCESS_WRITE,   MASK_UNDO, RESPONSE_RESULT},
+    // collections still on disk keep their snapshots
+    {"checkpoint",               handleCheckpoint,            ACCESS_WRITE,   0, RESPONSE_RESULT},
+    {"get_metrics",              handleGetMetrics,            ACCESS_READ,    0, RESPONSE_OBJECT},
+    // walks the live structures, not a copy: their layout is what it reports
+    {"get_engine_stats",         handleGetEngineStats,        ACCESS_READ,    MASK_ALL, RESPONSE_OBJECT},
+    {"list_commands",            handleListCommands,          ACCESS_READ,    0, RESPONSE_LIST},
+};
+
+constexpr PerfectHash<64> COMMAND_INDEX = PerfectHash<64>::build(COMMANDS);
+static_assert(COMMAND_INDEX.isValid(), "no collision-free seed for the command table");
+
+// Time Complexity: O(name length)
+const CommandSpec* findCommand(std::string_view name) {
+    int i = COMMAND_INDEX.candidate(name);
+    if (i < 0 || COMMANDS[i].name != name) return nullptr;
+    return &COMMANDS[i];
+}
+
+// Time Complexity: O(commands)
+void writeCommandList(JsonWriter& out) {
+    static const char* const ACCESS_NAMES[] = {"read", "snapshot", "write"};
+    out.raw("{\"commands\":[");
+    for (const CommandSpec& spec : COMMANDS) {
+        if (&spec != COMMANDS) out.raw(',');
+        out.raw("{\"name\":").string(spec.name)
+           .raw(",\"access\":").string(ACCESS_NAMES[spec.access]).raw('}');
+    }
+    out.raw("]}");
+}
+
+// ===== METRICS =====
+// Per-command latency since the process started, over all tenants. handler
+// is the command alone (under its lock or on its version); request is the
+// whole request: tenant lookup, lock waits, lazy loads, the log commit and
+// the wait for durability. Commands inside a batch count towards handler
+// only; the batch as a whole has its own histogram.
+
+const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+struct CommandMetrics {
+    LatencyHistogram handler;
+    LatencyHistogram request;
+};
+
+CommandMetrics commandMetrics[COMMAND_COUNT];
+LatencyHistogram batchLatency;
+const uint64_t processStart = monotonicNanos();
+
+// Where a request's end-to-end time goes (nullptr for an unknown command)
+LatencyHistogram* requestHistogram(const JsonFields& request) {
+    if (request.get("batch").kind == JsonValue::ARRAY) return &batchLatency;
+    const CommandSpec* spec = findCommand(request.getString("command"));
+    return spec ? &commandMetrics[spec - COMMANDS].request : nullptr;
+}
+
+// "name":{histogram}, skipping empty histograms
+void writeNamedHistogram(JsonWriter& out, bool& first, std::string_view name,
+                         const LatencyHistogram& histogram, bool buckets) {
+    if (histogram.count() == 0) return;
+    if (!first) out.raw(',');
+    first = false;
+    out.string(name).raw(':');
+    histogram.writeJson(out, buckets);
+}
+
+// {"uptimeSeconds":..,"enabled":..,"commands":{"<name>":{"request":{..},
+// "handler":{..}}},"batch":{..},"phases":{..},"structures":{..}}
+// Time Complexity: O(histograms * buckets)
+void writeMetrics(JsonWriter& out, bool buckets) {
+    out.raw("{\"uptimeSeconds\":").number((monotonicNanos() - processStart) / 1e9)
+       .raw(",\"enabled\":").boolean(metricsEnabled())
+       .raw(",\"commands\":{");
+    bool first = true;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        const CommandMetrics& metrics = commandMetrics[i];
+        if (metrics.handler.count() == 0 && metrics.request.count() == 0) continue;
+        if (!first) out.raw(',');
+        first = false;
+        out.string(COMMANDS[i].name).raw(":{\"request\":");
+        metrics.request.writeJson(out, buckets);
+        out.raw(",\"handler\":");
+        metrics.handler.writeJson(out, buckets);
+        out.raw('}');
+    }
+    
+    out.raw("},\"batch\":");
+    batchLatency.writeJson(out, buckets);
+    
+    out.raw(",\"phases\":{");
+    first = true;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        writeNamedHistogram(out, first, PHASE_NAMES[i], phaseLatency[i], buckets);
+    }
+    
+    out.raw("},\"structures\":{");
+    first = true;
+    for (int i = 0; i < STRUCTURE_OP_COUNT; i++) {
+        StructureOp op = static_cast<StructureOp>(i);
+        writeNamedHistogram(out, first, STRUCTURE_OP_NAMES[i], structureHistogram(op), buckets);
+    }
+    out.raw("}}");
+}
+
+// --stats-file: where the metrics are written when the process exits
+std::string statsFile;
+
+void writeStatsFile() {
+    if (statsFile.empty()) return;
+    JsonWriter out;
+    writeMetrics(out, true);
+    out.raw('\n');
+    if (!writeFileAtomic(statsFile, out.str())) {
+        std::cerr << "Warning: failed to write " << statsFile << std::endl;
+    }
+}
+
+// Everything due when the process exits: the stats file and the trace,
+// each only when enabled
+void writeExitReports() {
+    writeStatsFile();
+    if (!tracer().write()) {
+        std::cerr << "Warning: failed to write the trace file" << std::endl;
+    }
+}
+
+// Dispatch one {"command":...,"params":{...}} object. Without a "params"
+// object the envelope's own fields serve as the parameters. "stream":true
+// (in either) asks for NDJSON output, honoured only when allowStream is set
+// and the writer has a sink to stream to. The caller holds the engine (see
+// withTenant, withSnapshot) with the command's collections loaded.
+void dispatchRequest(FinanceEngine& engine, const JsonFields& request, JsonWriter& out,
+                     bool allowStream = false) {
+    std::string command = request.getString("command");
+    const CommandSpec* spec = findCommand(command);
+    if (!spec) {
+        out.raw("{\"error\":").string("Unknown command: " + command).raw('}');
+        return;
+    }
+    
+    JsonValue paramsValue = request.get("params");
+    
+    JsonFields params;
+    const JsonFields* effective = &request;
+    if (paramsValue.kind == JsonValue::OBJECT && params.parse(paramsValue.raw)) {
+        effective = &params;
+    }
+    
+    bool stream = allowStream && spec->shape == RESPONSE_PAGED && out.hasSink() &&
+                  (request.get("stream").boolean() || effective->get("stream").boolean());
+    ScopedTimer timer(commandMetrics[spec - COMMANDS].handler);
+    TraceSpan span("command", spec->name.data());  // names are literals, so terminated
+    spec->handler(engine, *effective, out, stream);
+}
+
+void writeError(JsonWriter& out, const std::string& message) {
+    out.raw("{\"error\":").string(message).raw('}');
+}
+
+// Add the collections one request touches; returns how it uses the engine
+CommandAccess addCommandNeeds(const JsonFields& request, unsigned& collections) {
+    const CommandSpec* spec = findCommand(request.getString("command"));
+    if (!spec) return ACCESS_READ;
+    collections |= spec->collections;
+    return spec->access;
+}
+
+// Take the tenant's shared lock with the needed collections in memory.
+// Loading them needs the lock exclusively for a moment.
+std::shared_lock<std::shared_mutex> lockShared(Tenant& tenant, unsigned needed) {
+    std::shared_lock<std::shared_mutex> guard(tenant.lock, std::defer_lock);
+    {
+        PhaseScope waiting(PHASE_LOCK_WAIT);
+        guard.lock();
+    }
+    while ((needed & ~tenant.loadedCollections) != 0) {
+        guard.unlock();
+        {
+            std::unique_lock<std::shared_mutex> loader(tenant.lock);
+            ensureLoaded(tenant, needed);
+            tenant.noteEngineChanged();
+        }
+        guard.lock();  // collections are never unloaded, so this settles
+    }
+    return guard;
+}
+
+// Run work against a tenant under its lock: shared for reads, so they run
+// concurrently, and exclusive for mutations, which are serialized and logged
+// before the lock is released. Collections still on disk are loaded first.
+// A mutation returns only once its log records are durable; with group
+// commit it waits for that outside the lock, so other writers can join the
+// same fsync.
+template<typename F>
+void withTenant(Tenant& tenant, unsigned needed, bool mutating, F work) {
+    if (mutating) {
+        uint64_t durable;
+        {
+            std::unique_lock<std::shared_mutex> guard(tenant.lock, std::defer_lock);
+            {
+                PhaseScope waiting(PHASE_LOCK_WAIT);
+                guard.lock();
             }
+            ensureLoaded(tenant, needed);
+            work();
+            tenant.noteEngineChanged();  // applied, even if logging it fails below
+            durable = commitMutations(tenant);
+        }
+        bool written = true;
+        if (durable) {
+            PhaseScope waiting(PHASE_DURABLE_WAIT);
+            written = tenant.wal.waitDurable(durable);
+        }
+        if (!written) {
+            // The group commit failed; a checkpoint since then (another
+            // writer's) covers this mutation too
+            std::unique_lock<std::shared_mutex> guard(tenant.lock);
+            if (tenant.wal.hasFailed()) checkpointAfterLogFailure(tenant);
         }
+        return;
     }
     
-    // Load bills
-    std::ifstream billFile(dataDir + "/bills.json");
-    if (billFile.is_open()) {
-        std::stringstream buffer;
-        buffer << billFile.rdbuf();
-        std::string content = buffer.str();
-        billFile.close();
-        
-        std::string arr = extractValue(content, "bills");
-        if (!arr.empty()) {
-            auto items = splitJsonArray(arr);
-            for (const auto& item : items) {
-                std::string id = extractValue(item, "id");
-                std::string name = extractValue(item, "name");
-                double amount = extractDouble(item, "amount");
-                std::string dueDate = extractValue(item, "dueDate");
-                std::string category = extractValue(item, "category");
-                bool isPaid = extractBool(item, "isPaid");
-                
-                if (!id.empty() && !name.empty()) {
-                    engine.loadBill(id, name, amount, dueDate, category, isPaid);
-                }
+    std::shared_lock<std::shared_mutex> guard = lockShared(tenant, needed);
+    work();
+}
+
+// Drop logged mutations the spare version already has
+void trimVersionLog(Tenant& tenant, unsigned needed, uint64_t sparePosition) {
+    std::shared_lock<std::shared_mutex> guard = lockShared(tenant, needed);
+    uint64_t logStart = tenant.versionLogEnd - tenant.versionLog.size();
+    size_t applied = sparePosition > logStart ? static_cast<size_t>(sparePosition - logStart) : 0;
+    tenant.versionLog.erase(tenant.versionLog.begin(),
+                            tenant.versionLog.begin() + std::min(applied, tenant.versionLog.size()));
+}
+
+// A published version still matches the engine and has what a read needs
+bool isCurrentVersion(const Tenant& tenant, const EngineVersion* version, unsigned needed) {
+    return version && version->version == tenant.committedVersion &&
+           (needed & ~version->loaded) == 0;
+}
+
+// Bring the tenant's spare version up to date by replaying the mutations
+// logged since it was published, outside the tenant's lock. Returns nullptr
+// when it cannot: no spare yet, a reader may still be on it, collections were
+// loaded since, or the log no longer reaches back to it. Caller holds
+// publishMutex; the shared lock is taken here only to copy the missing mutations.
+// Time Complexity: O(mutations since the spare's version)
+EngineVersion* catchUpSpare(Tenant& tenant, unsigned needed) {
+    EngineVersion* spare = tenant.spare;
+    if (!spare || !versionEpochs.isQuiescent(tenant.spareEpoch)) return nullptr;
+    
+    std::vector<Mutation> missing;
+    uint64_t target;
+    uint64_t position;
+    {
+        std::shared_lock<std::shared_mutex> guard = lockShared(tenant, needed);
+        uint64_t logStart = tenant.versionLogEnd - tenant.versionLog.size();
+        if (spare->loaded != tenant.loadedCollections || spare->logPosition < logStart) return nullptr;
+        missing.assign(tenant.versionLog.begin() + (spare->logPosition - logStart), tenant.versionLog.end());
+        target = tenant.engine.getVersion();
+        position = tenant.versionLogEnd;
+    }
+    
+    PhaseScope replaying(PHASE_PUBLISH);
+    for (const auto& m : missing) spare->engine.applyMutation(m);
+    tenant.spare = nullptr;
+    // A change that never reached the log (none should) shows up as a version
+    // mismatch; the spare is then dropped and the engine copied instead
+    if (spare->engine.getVersion() != target) {
+        delete spare;
+        return nullptr;
+    }
+    spare->version = target;
+    spare->logPosition = position;
+    return spare;
+}
+
+// Run a long read on the tenant's published version instead of its engine,
+// so writers never wait for it (MVCC). The reader pins the version through
+// an epoch rather than a lock. After a write, the first such read publishes
+// a new version: two versions alternate, and the one published before
+// catches up by replaying the mutations since (outside the lock). Only the
+// first version, and one after a lazy load, copies the whole engine under
+// the shared lock.
+template<typename F>
+void withSnapshot(Tenant& tenant, unsigned needed, F work) {
+    EpochGuard epoch(versionEpochs);
+    EngineVersion* version = tenant.published.load();
+    if (!isCurrentVersion(tenant, version, needed)) {
+        std::lock_guard<std::mutex> publishing(tenant.publishMutex);
+        version = tenant.published.load();
+        if (!isCurrentVersion(tenant, version, needed)) {
+            EngineVersion* next = catchUpSpare(tenant, needed);
+            if (!next) {
+                if (tenant.spare) versionEpochs.retire(tenant.spare);  // readers may still be on it
+                tenant.spare = nullptr;
+                std::shared_lock<std::shared_mutex> guard = lockShared(tenant, needed);
+                PhaseScope copying(PHASE_PUBLISH);
+                next = new EngineVersion(tenant.engine, tenant.loadedCollections, tenant.versionLogEnd);
+                tenant.keepVersionLog = true;
+            }
+            tenant.published.store(next);
+            if (version) {
+                tenant.spare = version;
+                tenant.spareEpoch = versionEpochs.unpublish();
+                trimVersionLog(tenant, needed, version->logPosition);
             }
+            version = next;
+        }
+    }
+    work(version->engine);
+}
+
+// Run every command of a {"batch":[...]} envelope against the one loaded engine.
+// A failing command reports its error in its own slot; the rest still run.
+void handleBatch(Tenant& tenant, std::string_view batch, JsonWriter& out) {
+    // Load what the whole batch needs up front, so no lazy load (or its
+    // recovery) lands between commands whose mutations are not logged yet.
+    // A batch holding any mutation runs exclusively, and is logged with one
+    // append and fsync.
+    unsigned needed = 0;
+    bool mutating = false;
+    JsonReader scan(batch);
+    scan.beginArray();
+    while (scan.nextElement()) {
+        JsonValue item = scan.readValue();
+        JsonFields request;
+        if (item.kind == JsonValue::OBJECT && request.parse(item.raw)) {
+            mutating = addCommandNeeds(request, needed) == ACCESS_WRITE || mutating;
         }
     }
     
-    // Load undo stack (NEW - for persistence across commands)
-    std::ifstream undoFile(dataDir + "/undo_stack.json");
-    if (undoFile.is_open()) {
-        std::stringstream buffer;
-        buffer << undoFile.rdbuf();
-        std::string content = buffer.str();
-        undoFile.close();
+    withTenant(tenant, needed, mutating, [&] {
+        JsonReader reader(batch);
+        reader.beginArray();
         
-        std::string arr = extractValue(content, "actions");
-        if (!arr.empty()) {
-            auto items = splitJsonArray(arr);
-            // Load in reverse order since we're pushing to stack
-            for (int i = items.size() - 1; i >= 0; i--) {
-                int type = extractInt(items[i], "type");
-                std::string data = extractValue(items[i], "data");
-                engine.loadUndoAction(static_cast<ActionType>(type), data);
+        out.raw("{\"results\":[");
+        bool first = true;
+        while (reader.nextElement()) {
+            JsonValue item = reader.readValue();
+            if (!first) out.raw(',');
+            first = false;
+            
+            JsonFields request;
+            bool parsed;
+            {
+                TraceSpan parsing("request", "parse");
+                parsed = item.kind == JsonValue::OBJECT && request.parse(item.raw);
+            }
+            if (!parsed) {
+                writeError(out, "Invalid request in batch");
+                continue;
+            }
+            size_t mark = out.position();
+            try {
+                dispatchRequest(tenant.engine, request, out);
+            } catch (const std::exception& e) {
+                out.truncate(mark);
+                writeError(out, e.what());
             }
         }
-    }
+        out.raw("]}");
+    });
 }
 
-// Save data to files
-void saveData(const std::string& dataDir) {
-    // Save transactions
-    std::ofstream transFile(dataDir + "/transactions.json");
-    if (transFile.is_open()) {
-        transFile << "{\"transactions\":[";
-        auto transactions = engine.getAllTransactions();
-        for (size_t i = 0; i < transactions.size(); i++) {
-            if (i > 0) transFile << ",";
-            transFile << transactionToJson(transactions[i]);
+// ===== TENANTS =====
+// The daemon keeps one resident engine per data directory, in an LRU cache
+// charged with each engine's approximate memory use. A tenant loads on its
+// first request; when the total goes over the budget, the least recently
+// used tenants are checkpointed and dropped (they reload from that snapshot).
+// Loads and eviction checkpoints run outside tenantsMutex, so a cold tenant
+// never stalls requests for the others.
+
+const size_t DEFAULT_MEMORY_BUDGET_MB = 256;
+
+LruCache<Tenant> tenants;
+std::mutex tenantsMutex;  // guards tenants, closingTenants, every Tenant::pins and loading
+std::condition_variable tenantsChanged;  // a load or an eviction checkpoint finished
+std::unordered_set<std::string> closingTenants;  // evicted, checkpoint still running
+std::string defaultDataDir = "../data";
+std::string tenantRoot;  // --tenant-root: where named tenants live
+size_t memoryBudget = DEFAULT_MEMORY_BUDGET_MB << 20;
+
+// Tenant names become directory names, so no separators and no "." / ".."
+bool isValidTenantName(const std::string& name) {
+    if (name.empty() || name.size() > 128 || name == "." || name == "..") return false;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.') {
+            return false;
         }
-        transFile << "]}";
-        transFile.close();
     }
+    return true;
+}
+
+// Data directory a request addresses: its "tenant" under the tenant root,
+// or the default directory when it names none. Nothing is created here; a
+// tenant's directory appears with its first write (see commitMutations).
+std::string tenantDataDir(const JsonFields& request) {
+    JsonValue name = request.get("tenant");
+    if (name.isMissing()) return defaultDataDir;
     
-    // Save budgets
-    std::ofstream budgetFile(dataDir + "/budgets.json");
-    if (budgetFile.is_open()) {
-        budgetFile << "{\"budgets\":[";
-        auto budgets = engine.getAllBudgets();
-        for (size_t i = 0; i < budgets.size(); i++) {
-            if (i > 0) budgetFile << ",";
-            budgetFile << "{\"category\":\"" << escapeJson(budgets[i].category) << "\","
-                       << "\"limit\":" << budgets[i].limit << "}";
+    std::string tenant = request.getString("tenant");
+    if (tenantRoot.empty()) {
+        throw std::runtime_error("Tenants are not enabled (start with --tenant-root)");
+    }
+    if (!isValidTenantName(tenant)) {
+        throw std::runtime_error("Invalid tenant name");
+    }
+    return tenantRoot + "/" + tenant;
+}
+
+// Resident tenant for a data directory, loading it on a miss. The first
+// request inserts a pinned placeholder and loads it without tenantsMutex;
+// requests for the same directory wait for that load (or for an eviction
+// checkpoint still writing it) instead of reading it a second time. A named
+// tenant with no directory starts empty without creating anything.
+Tenant& acquireTenant(const std::string& dataDir) {
+    std::unique_lock<std::mutex> guard(tenantsMutex);
+    Tenant* tenant;
+    while (true) {
+        tenant = tenants.get(dataDir);
+        if (tenant && !tenant->loading) {
+            tenant->pins++;
+            return *tenant;
         }
-        budgetFile << "]}";
-        budgetFile.close();
+        if (!tenant && closingTenants.count(dataDir) == 0) break;
+        tenantsChanged.wait(guard);
     }
     
-    // Save bills
-    std::ofstream billFile(dataDir + "/bills.json");
-    if (billFile.is_open()) {
-        billFile << "{\"bills\":[";
-        auto bills = engine.getAllBills();
-        for (size_t i = 0; i < bills.size(); i++) {
-            if (i > 0) billFile << ",";
-            billFile << billToJson(bills[i]);
+    tenant = tenants.put(dataDir, std::unique_ptr<Tenant>(new Tenant(dataDir)));
+    tenant->loading = true;
+    tenant->pins++;
+    guard.unlock();
+    
+    try {
+        if (dataDir != defaultDataDir && !directoryExists(dataDir)) {
+            tenant->onDisk = false;  // starts empty; nothing to read
+            tenant->loadedCollections = MASK_ALL;
+        } else {
+            loadData(*tenant);
         }
-        billFile << "]}";
-        billFile.close();
+        tenant->noteEngineChanged();
+    } catch (...) {
+        // Waiters retry the load themselves and report their own error
+        guard.lock();
+        tenants.remove(dataDir);
+        tenantsChanged.notify_all();
+        throw;
     }
     
-    // Save undo stack (NEW - for persistence across commands)
-    std::ofstream undoFile(dataDir + "/undo_stack.json");
-    if (undoFile.is_open()) {
-        undoFile << "{\"actions\":[";
-        auto actions = engine.getUndoActions();
-        for (size_t i = 0; i < actions.size(); i++) {
-            if (i > 0) undoFile << ",";
-            undoFile << "{\"type\":" << actions[i].type << ","
-                     << "\"data\":\"" << escapeJson(actions[i].data) << "\"}";
-        }
-        undoFile << "]}";
-        undoFile.close();
+    guard.lock();
+    tenant->loading = false;
+    tenantsChanged.notify_all();
+    return *tenant;
+}
+
+// Fold the log into a checkpoint so the next load reads snapshots only;
+// the log itself is closed when the tenant is destroyed
+void evictTenant(Tenant& tenant) {
+    if (tenant.wal.size() > 0 && !saveData(tenant)) {
+        std::cerr << "Warning: failed to checkpoint " << tenant.dataDir << " on eviction" << std::endl;
+    }
+}
+
+// Unpin a tenant after a request, recharge it, and evict colder ones over
+// the budget. Tenants in use, the one just released and the default tenant
+// are never evicted, even over the budget: one tenant larger than the budget
+// stays resident instead of reloading on every request. The evicted tenants
+// are checkpointed and closed after tenantsMutex is released; until then
+// closingTenants keeps their directories from being reloaded.
+void releaseTenant(Tenant& tenant) {
+    std::vector<std::unique_ptr<Tenant>> evicted;
+    {
+        std::lock_guard<std::mutex> guard(tenantsMutex);
+        tenant.pins--;
+        tenants.setCost(tenant.dataDir, tenant.approximateBytes);
+        // Versions for long reads count against the budget too, but apart
+        // from residency: they are freed with their tenant or when superseded
+        size_t versions = versionBytes;
+        size_t residentBudget = memoryBudget > versions ? memoryBudget - versions : 0;
+        auto canEvict = [&](const std::string& dataDir, Tenant& t) {
+            return t.pins == 0 && &t != &tenant && dataDir != defaultDataDir;
+        };
+        tenants.evictOver(residentBudget, canEvict,
+                          [&](const std::string& dataDir, std::unique_ptr<Tenant> cold) {
+                              closingTenants.insert(dataDir);
+                              evicted.push_back(std::move(cold));
+                          });
+        versionEpochs.reclaim();  // versions whose last reader was this request
+    }
+    if (evicted.empty()) return;
+    
+    std::vector<std::string> closed;
+    for (auto& cold : evicted) {
+        evictTenant(*cold);
+        closed.push_back(cold->dataDir);
+        cold.reset();  // closes the log before the directory can reload
+    }
+    
+    std::lock_guard<std::mutex> guard(tenantsMutex);
+    for (const std::string& dataDir : closed) closingTenants.erase(dataDir);
+    tenantsChanged.notify_all();
+}
+
+// Pins a tenant for the length of one request
+class TenantLease {
+private:
+    Tenant& held;
+    
+public:
+    explicit TenantLease(const std::string& dataDir) : held(acquireTenant(dataDir)) {}
+    ~TenantLease() { releaseTenant(held); }
+    
+    TenantLease(const TenantLease&) = delete;
+    TenantLease& operator=(const TenantLease&) = delete;
+    
+    Tenant& tenant() { return held; }
+};
+
+// Handle one request line: dispatch the command (or batch) to its tenant and
+// persist what it changed
+void handleRequest(const std::string& input, JsonWriter& out) {
+    TraceSpan span("request", "request");
+    JsonFields request;
+    bool parsed;
+    {
+        TraceSpan parsing("request", "parse");
+        parsed = request.parse(input);
+    }
+    if (!parsed) {
+        writeError(out, "Invalid JSON request");
+        return;
     }
+    ScopedTimer timer(requestHistogram(request));
+    
+    TenantLease lease(tenantDataDir(request));
+    Tenant& tenant = lease.tenant();
+    
+    JsonValue batch = request.get("batch");
+    if (batch.kind == JsonValue::ARRAY) {
+        handleBatch(tenant, batch.raw, out);
+        return;
+    }
+    
+    unsigned needed = 0;
+    CommandAccess access = addCommandNeeds(request, needed);
+    if (access == ACCESS_SNAPSHOT) {
+        withSnapshot(tenant, needed, [&](FinanceEngine& engine) {
+            dispatchRequest(engine, request, out, true);
+        });
+        return;
+    }
+    
+    // Mutations (including undo stack changes) are logged inside withTenant
+    withTenant(tenant, needed, access == ACCESS_WRITE, [&] {
+        dispatchRequest(tenant.engine, request, out, true);
+    });
 }
 
-// Process command and return JSON result
-std::string processCommand(const std::string& command, const std::string& params) {
-    std::ostringstream result;
-    result << std::fixed << std::setprecision(2);
+// ===== CAPTURE =====
+// --capture PATH appends one NDJSON record per request, for finance_replay:
+// {"timeUs":<wall clock at arrival>,"us":<time to answer>,"crc":"<CRC-32C
+// of the response line>","request":"<request line>"}. Records follow the
+// order in which responses complete. One-shot runs append to the same file; each
+// record is a single append, so concurrent processes do not interleave.
+
+class CaptureLog {
+private:
+    FILE* file;
+    std::mutex mutex;
+    
+public:
+    CaptureLog() : file(nullptr) {}
+    
+    bool open(const std::string& path) {
+        file = std::fopen(path.c_str(), "ab");
+        if (file) std::setvbuf(file, nullptr, _IONBF, 0);  // one write per record
+        return file != nullptr;
+    }
+    
+    bool isOpen() const { return file != nullptr; }
+    
+    static long long wallMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
     
-    if (command == "add_transaction") {
-        std::string type = extractValue(params, "type");
-        double amount = extractDouble(params, "amount");
-        std::string category = extractValue(params, "category");
-        std::string description = extractValue(params, "description");
-        std::string date = extractValue(params, "date");
+    void record(const std::string& request, long long startUs, uint32_t crc, uint64_t nanos) {
+        char hex[16];
+        std::snprintf(hex, sizeof(hex), "%08x", crc);
         
-        if (date.empty()) {
-            // Get current date
-            time_t now = time(0);
-            tm* ltm = localtime(&now);
-            char buffer[11];
-            strftime(buffer, 11, "%Y-%m-%d", ltm);
-            date = buffer;
+        JsonWriter line;
+        line.raw("{\"timeUs\":").integer(startUs)
+            .raw(",\"us\":").number(nanos / 1000.0)
+            .raw(",\"crc\":\"").raw(hex)
+            .raw("\",\"request\":").string(request).raw("}\n");
+        std::lock_guard<std::mutex> guard(mutex);
+        std::fwrite(line.data(), 1, line.size(), file);
+    }
+};
+
+CaptureLog captureLog;
+
+// Run handle() to answer one request line, and log the line with a
+// checksum of the response when capturing
+template<typename F>
+void captureRequest(const std::string& input, JsonWriter& out, F handle) {
+    if (!captureLog.isOpen()) {
+        handle();
+        return;
+    }
+    long long startUs = CaptureLog::wallMicros();
+    uint64_t start = monotonicNanos();
+    out.beginDigest();
+    handle();
+    captureLog.record(input, startUs, out.endDigest(), monotonicNanos() - start);
+}
+
+// Same as handleRequest, but a bad request must not take the resident engine
+// down. Damaged data is an error response too, unless damageFails: then it
+// propagates (one-shot runs exit on it).
+void handleRequestSafe(const std::string& input, JsonWriter& out, bool damageFails = false) {
+    captureRequest(input, out, [&] {
+        size_t mark = out.position();
+        try {
+            handleRequest(input, out);
+        } catch (const DamagedData& e) {
+            if (damageFails) throw;
+            out.truncate(mark);
+            writeError(out, e.what());
+        } catch (const std::exception& e) {
+            out.truncate(mark);
+            writeError(out, e.what());
         }
+    });
+}
+
+bool isBlankLine(const std::string& line) {
+    return line.find_first_not_of(" \t\r\n") == std::string::npos;
+}
+
+// ===== RESIDENT (SERVE) MODE =====
+// Engines stay loaded (see TENANTS) and answer newline-delimited commands
+// from memory, one JSON response line per request line.
+
+unsigned workerCount = 0;  // --workers (socket mode); 0 = one per hardware thread
+
+// Serve requests from stdin until EOF
+int serveStdin() {
+    JsonWriter out;
+    out.setSink(stdout);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (isBlankLine(line)) continue;
+        handleRequestSafe(line, out);
+        out.raw('\n');
+        out.flushTo(stdout);
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+// Serve one connected client until it disconnects
+void serveClient(int client) {
+    std::string pending;
+    char buffer[4096];
+    JsonWriter out;
+    out.setSink(client);
+    
+    while (true) {
+        ssize_t n = read(client, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, n);
         
-        Transaction t = engine.addTransaction(type, amount, category, description, date);
-        result << "{\"success\":true,\"transaction\":" << transactionToJson(t) 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "delete_transaction") {
-        std::string id = extractValue(params, "id");
-        bool success = engine.deleteTransaction(id);
-        result << "{\"success\":" << (success ? "true" : "false") 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "get_transactions") {
-        auto transactions = engine.getTransactionsByDateDesc();
-        result << "{\"transactions\":[";
-        for (size_t i = 0; i < transactions.size(); i++) {
-            if (i > 0) result << ",";
-            result << transactionToJson(transactions[i]);
-        }
-        result << "]}";
-    }
-    else if (command == "get_recent_transactions") {
-        int count = 10;
-        std::string countStr = extractValue(params, "count");
-        if (!countStr.empty()) {
-            count = std::stoi(countStr);
-        }
-        auto transactions = engine.getRecentTransactions(count);
-        result << "{\"transactions\":[";
-        for (size_t i = 0; i < transactions.size(); i++) {
-            if (i > 0) result << ",";
-            result << transactionToJson(transactions[i]);
-        }
-        result << "],\"dsInfo\":\"Recent transactions from Stack (LIFO)\"}";
-    }
-    else if (command == "get_transactions_by_date") {
-        std::string startDate = extractValue(params, "startDate");
-        std::string endDate = extractValue(params, "endDate");
-        auto transactions = engine.getTransactionsInRange(startDate, endDate);
-        result << "{\"transactions\":[";
-        for (size_t i = 0; i < transactions.size(); i++) {
-            if (i > 0) result << ",";
-            result << transactionToJson(transactions[i]);
-        }
-        result << "],\"dsInfo\":\"Date range query using BST\"}";
-    }
-    else if (command == "set_budget") {
-        std::string category = extractValue(params, "category");
-        double limit = extractDouble(params, "limit");
-        engine.setBudget(category, limit);
-        Budget b;
-        engine.getBudget(category, b);
-        result << "{\"success\":true,\"budget\":" << budgetToJson(b) 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "get_budgets") {
-        auto budgets = engine.getAllBudgets();
-        result << "{\"budgets\":[";
-        for (size_t i = 0; i < budgets.size(); i++) {
-            if (i > 0) result << ",";
-            result << budgetToJson(budgets[i]);
-        }
-        result << "],\"dsInfo\":\"Budget data stored in HashMap\"}";
-    }
-    else if (command == "get_alerts") {
-        auto alerts = engine.getBudgetAlerts();
-        result << "{\"alerts\":[";
-        for (size_t i = 0; i < alerts.size(); i++) {
-            if (i > 0) result << ",";
-            result << alertToJson(alerts[i]);
-        }
-        result << "]}";
-    }
-    else if (command == "add_bill") {
-        std::string name = extractValue(params, "name");
-        double amount = extractDouble(params, "amount");
-        std::string dueDate = extractValue(params, "dueDate");
-        std::string category = extractValue(params, "category");
-        
-        Bill b = engine.addBill(name, amount, dueDate, category);
-        result << "{\"success\":true,\"bill\":" << billToJson(b) 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "get_bills") {
-        auto bills = engine.getAllBills();
-        result << "{\"bills\":[";
-        for (size_t i = 0; i < bills.size(); i++) {
-            if (i > 0) result << ",";
-            result << billToJson(bills[i]);
-        }
-        result << "],\"dsInfo\":\"Bills managed in Queue (FIFO)\"}";
-    }
-    else if (command == "pay_bill") {
-        std::string id = extractValue(params, "id");
-        bool success = engine.payBill(id);
-        result << "{\"success\":" << (success ? "true" : "false") 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "delete_bill") {
-        std::string id = extractValue(params, "id");
-        bool success = engine.removeBill(id);
-        result << "{\"success\":" << (success ? "true" : "false") 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "get_top_expenses") {
-        int k = 5;
-        std::string kStr = extractValue(params, "count");
-        if (!kStr.empty()) {
-            k = std::stoi(kStr);
-        }
-        auto expenses = engine.getTopExpenses(k);
-        result << "{\"topExpenses\":[";
-        for (size_t i = 0; i < expenses.size(); i++) {
-            if (i > 0) result << ",";
-            result << transactionToJson(expenses[i]);
-        }
-        result << "],\"dsInfo\":\"Top expenses extracted from Max Heap\"}";
-    }
-    else if (command == "get_top_categories") {
-        int k = 5;
-        std::string kStr = extractValue(params, "count");
-        if (!kStr.empty()) {
-            k = std::stoi(kStr);
-        }
-        auto categories = engine.getTopCategories(k);
-        result << "{\"topCategories\":[";
-        for (size_t i = 0; i < categories.size(); i++) {
-            if (i > 0) result << ",";
-            result << categoryAmountToJson(categories[i]);
-        }
-        result << "],\"dsInfo\":\"Top categories from Category Max Heap\"}";
-    }
-    else if (command == "get_monthly_summary") {
-        std::string month = extractValue(params, "month");
-        if (month.empty()) {
-            time_t now = time(0);
-            tm* ltm = localtime(&now);
-            char buffer[8];
-            strftime(buffer, 8, "%Y-%m", ltm);
-            month = buffer;
-        }
-        MonthlySummary summary = engine.getMonthlySummary(month);
-        result << "{\"summary\":" << summaryToJson(summary) << ",\"dsInfo\":\"Monthly data from BST range query\"}";
-    }
-    else if (command == "get_category_suggestions") {
-        std::string prefix = extractValue(params, "prefix");
-        auto suggestions = engine.getCategorySuggestions(prefix);
-        result << "{\"suggestions\":[";
-        for (size_t i = 0; i < suggestions.size(); i++) {
-            if (i > 0) result << ",";
-            result << "\"" << escapeJson(suggestions[i]) << "\"";
-        }
-        result << "],\"dsInfo\":\"Autocomplete using Trie\"}";
-    }
-    else if (command == "get_all_categories") {
-        auto categories = engine.getAllCategories();
-        result << "{\"categories\":[";
-        for (size_t i = 0; i < categories.size(); i++) {
-            if (i > 0) result << ",";
-            result << "\"" << escapeJson(categories[i]) << "\"";
-        }
-        result << "]}";
-    }
-    else if (command == "undo") {
-        bool success = engine.undo();
-        result << "{\"success\":" << (success ? "true" : "false") 
-               << ",\"canUndo\":" << (engine.canUndo() ? "true" : "false") 
-               << ",\"dsInfo\":\"Undo operation using Stack\"}";
-    }
-    else if (command == "get_dashboard") {
-        result << "{\"balance\":" << engine.getTotalBalance() << ","
-               << "\"totalIncome\":" << engine.getTotalIncome() << ","
-               << "\"totalExpenses\":" << engine.getTotalExpenses() << ","
-               << "\"transactionCount\":" << engine.getTransactionCount() << ","
-               << "\"budgetCount\":" << engine.getBudgetCount() << ","
-               << "\"billCount\":" << engine.getBillCount() << ","
-               << "\"canUndo\":" << (engine.canUndo() ? "true" : "false") << "}";
-    }
-    else if (command == "clear_undo") {
-        engine.clearUndoStack();
-        result << "{\"success\":true,\"canUndo\":false}";
-    }
-    else {
-        result << "{\"error\":\"Unknown command: " << escapeJson(command) << "\"}";
-    }
-    
-    return result.str();
+        size_t start = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, newline - start);
+            start = newline + 1;
+            if (isBlankLine(line)) continue;
+            handleRequestSafe(line, out);
+            out.raw('\n');
+        }
+        // Answer everything that arrived in this read with one write
+        if (!out.empty() && !out.flushTo(client)) return;
+        pending.erase(0, start);
+    }
 }
 
+// Accepted connections waiting for a worker
+class ClientQueue {
+private:
+    std::deque<int> clients;
+    std::mutex mutex;
+    std::condition_variable ready;
+    
+public:
+    void push(int client) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            clients.push_back(client);
+        }
+        ready.notify_one();
+    }
+    
+    // Block until a connection is waiting
+    int pop() {
+        std::unique_lock<std::mutex> guard(mutex);
+        ready.wait(guard, [this] { return !clients.empty(); });
+        int client = clients.front();
+        clients.pop_front();
+        return client;
+    }
+};
+
+// Serve requests over a Unix domain socket. Each worker serves one client
+// connection at a time, so clients on separate connections run concurrently
+// (reads in parallel, writes serialized per tenant, see withTenant).
+int serveSocket(const std::string& socketPath) {
+    signal(SIGPIPE, SIG_IGN);
+    
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::perror("socket");
+        return 1;
+    }
+    
+    unlink(socketPath.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listener, 16) < 0) {
+        std::perror("bind/listen");
+        close(listener);
+        return 1;
+    }
+    
+    unsigned workers = workerCount;
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    
+    ClientQueue pending;
+    for (unsigned i = 0; i < workers; i++) {
+        // Workers live as long as the process; a failing listener exits it
+        std::thread([&pending] {
+            tracer().nameThread("worker");
+            while (true) {
+                int client = pending.pop();
+                serveClient(client);
+                close(client);
+            }
+        }).detach();
+    }
+    
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::perror("accept");
+            break;
+        }
+        pending.push(client);
+    }
+    
+    close(listener);
+    unlink(socketPath.c_str());
+    // Every commit is already durable; skip static destructors, which would
+    // tear down tenants the detached workers may still be using
+    writeExitReports();
+    std::_Exit(1);
+}
+
+// With --stats-file or tracing on, SIGINT and SIGTERM write those files
+// before the process exits. The signals are blocked here, before any other thread exists, so
+// every thread inherits the mask and only this one takes them (sigwait),
+// where writing a file is safe.
+void writeReportsOnSignal() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::thread([signals] {
+        int sig = 0;
+        sigwait(&signals, &sig);
+        writeExitReports();
+        std::_Exit(128 + sig);
+    }).detach();
+}
+#endif
+
 int main(int argc, char* argv[]) {
-    std::string dataDir = "../data";
+    bool serve = false;
+    bool importJson = false;
+    bool exportJsonFiles = false;
+    std::string socketPath;
+    std::string capturePath;
+    double commitWindowMs = -1;
+    const char* traceEnv = std::getenv("FINANCE_TRACE");
+    std::string tracePath = traceEnv ? traceEnv : "";
     
-    // Parse arguments
-    if (argc >= 2) {
-        dataDir = argv[1];
+    // Parse arguments: [dataDir] [--serve] [--socket PATH] [--workers N]
+    // [--tenant-root DIR] [--memory-budget MB] [--commit-window-ms MS]
+    // [--checkpoint-mb MB] [--stats-file PATH] [--no-metrics] [--trace PATH]
+    // [--capture PATH]
+    // [--import-json] [--export-json] [--salvage-log]
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--import-json") {
+            importJson = true;
+        } else if (arg == "--export-json") {
+            exportJsonFiles = true;
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg == "--socket" && i + 1 < argc) {
+            serve = true;
+            socketPath = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workerCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--commit-window-ms" && i + 1 < argc) {
+            commitWindowMs = std::max(0.0, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--checkpoint-mb" && i + 1 < argc) {
+            double mb = std::max(0.0, std::strtod(argv[++i], nullptr));
+            checkpointBytes = static_cast<size_t>(mb * (1 << 20));
+        } else if (arg == "--tenant-root" && i + 1 < argc) {
+            tenantRoot = argv[++i];
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            memoryBudget = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (arg == "--stats-file" && i + 1 < argc) {
+            statsFile = argv[++i];
+        } else if (arg == "--no-metrics") {
+            metricsEnabled() = false;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (arg == "--salvage-log") {
+            salvageLog = true;
+        } else {
+            defaultDataDir = arg;
+        }
     }
     
-    // Load existing data (including undo stack)
-    loadData(dataDir);
+    // Stats and trace are written on any exit from here on; signals need
+    // their thread in place before the flusher starts
+    if (!tracePath.empty()) {
+        tracer().start(tracePath);
+        tracer().nameThread("main");
+    }
+    if (!statsFile.empty() || tracer().active()) {
+        std::atexit(writeExitReports);
+#ifndef _WIN32
+        writeReportsOnSignal();
+#endif
+    }
+    if (!capturePath.empty() && !captureLog.open(capturePath)) {
+        std::cerr << "Error: cannot open capture file " << capturePath << std::endl;
+        return 1;
+    }
+    if (commitWindowMs >= 0) {
+        walFlusher.reset(new WalFlusher(std::chrono::microseconds(static_cast<long long>(commitWindowMs * 1000))));
+    }
+    
+    // Load existing data (including undo stack) for the default tenant
+    std::unique_ptr<Tenant> initial(new Tenant(defaultDataDir));
+    try {
+        loadData(*initial, importJson);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    initial->noteEngineChanged();
+    Tenant& tenant = *tenants.put(defaultDataDir, std::move(initial));
+    
+    // Import/export are one-off maintenance runs (loadData already wrote a
+    // checkpoint after the JSON import)
+    if (importJson || exportJsonFiles) {
+        if (exportJsonFiles) {
+            try {
+                ensureLoaded(tenant, MASK_ALL);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
+            }
+            if (!exportJson(tenant.engine, tenant.dataDir)) {
+                std::cerr << "Error: failed to export JSON to " << tenant.dataDir << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    
+    if (serve) {
+        if (socketPath.empty()) {
+            return serveStdin();
+        }
+#ifndef _WIN32
+        return serveSocket(socketPath);
+#else
+        std::cerr << "--socket is not supported on this platform" << std::endl;
+        return 1;
+#endif
+    }
     
     // Read command from stdin (JSON format)
     std::string input;
     std::getline(std::cin, input);
     
-    std::string command = extractValue(input, "command");
-    std::string params = extractValue(input, "params");
-    
-    // Process command
-    std::string output = processCommand(command, params.empty() ? input : params);
-    
-    // Save data after modifications (including undo stack)
-    if (command == "add_transaction" || command == "delete_transaction" ||
-        command == "set_budget" || command == "add_bill" || 
-        command == "pay_bill" || command == "delete_bill" || 
-        command == "undo" || command == "clear_undo") {
-        saveData(dataDir);
+    // A request that fails gets the same {"error":...} response as in serve
+    // mode; damaged data found by a lazy load fails the run, as at startup
+    JsonWriter out;
+    out.setSink(stdout);
+    try {
+        handleRequestSafe(input, out, true);
+    } catch (const DamagedData& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
     
     // Output result
-    std::cout << output << std::endl;
+    out.raw('\n');
+    out.flushTo(stdout);
     
     return 0;
 }
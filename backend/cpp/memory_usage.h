@@ -0,0 +1,27 @@
+// Memory Accounting Helpers for the Data Structures
+// Data Structures & Applications Lab Project
+// Operations: heap bytes owned by a string, size + footprint of a linear container
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <string>
+
+// Bytes a string holds outside its own object: none while it fits in the
+// inline (small string) buffer, its capacity plus the terminator after that
+inline size_t stringHeapBytes(const std::string& s) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+}
+
+// Element count and approximate footprint (nodes plus what their fields
+// own) of a list, queue or stack. Allocator headers are not counted.
+struct ContainerStats {
+    int size;
+    size_t bytes;
+    
+    ContainerStats() : size(0), bytes(0) {}
+};
+
+#endif // MEMORY_USAGE_H
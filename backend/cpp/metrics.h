@@ -0,0 +1,156 @@
+// Log-Linear Latency Histograms for Engine Instrumentation
+// Data Structures & Applications Lab Project
+// Operations: record a duration (lock-free), percentiles, scoped timers, JSON export
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "json_writer.h"
+
+// Instrumentation can be switched off (--no-metrics) to measure its cost;
+// set before any thread starts
+inline bool& metricsEnabled() {
+    static bool enabled = true;
+    return enabled;
+}
+
+inline uint64_t monotonicNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Durations in ns. Each power of two is split into 8 linear sub-buckets, so
+// a bucket is at most 12.5% wide and the whole range up to ~18 minutes takes
+// 312 counters. Recording is a few relaxed atomic adds: many request
+// threads share one histogram without a lock.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 3;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int MAX_SHIFT = 37;    // values are clamped below 2^40 ns
+    static const int BUCKET_COUNT = SUB_COUNT + (MAX_SHIFT + 1) * SUB_COUNT;
+
+private:
+    std::atomic<uint64_t> counts[BUCKET_COUNT];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maximum;
+    
+    static int highestBit(uint64_t value) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1) bit++;
+        return bit;
+#endif
+    }
+
+public:
+    LatencyHistogram() : total(0), sum(0), maximum(0) {
+        for (int i = 0; i < BUCKET_COUNT; i++) counts[i].store(0, std::memory_order_relaxed);
+    }
+    
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+    
+    static int bucketOf(uint64_t ns) {
+        if (ns < static_cast<uint64_t>(SUB_COUNT)) return static_cast<int>(ns);
+        int shift = highestBit(ns) - SUB_BITS;
+        if (shift > MAX_SHIFT) return BUCKET_COUNT - 1;
+        int sub = static_cast<int>(ns >> shift) - SUB_COUNT;
+        return SUB_COUNT + shift * SUB_COUNT + sub;
+    }
+    
+    // Largest value that lands in a bucket
+    static uint64_t bucketUpper(int bucket) {
+        if (bucket < SUB_COUNT) return static_cast<uint64_t>(bucket);
+        int shift = (bucket - SUB_COUNT) / SUB_COUNT;
+        uint64_t sub = static_cast<uint64_t>((bucket - SUB_COUNT) % SUB_COUNT);
+        return ((SUB_COUNT + sub + 1) << shift) - 1;
+    }
+    
+    // Time Complexity: O(1)
+    void record(uint64_t ns) {
+        counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (ns > seen && !maximum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+    
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const {
+        uint64_t n = count();
+        return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+    
+    // Upper bound of the bucket holding the p-th quantile (0 < p <= 1),
+    // never above the largest value seen. Concurrent records may be
+    // partly counted; a snapshot is approximate while writes go on.
+    // Time Complexity: O(buckets)
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * n + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(bucketUpper(i), max());
+        }
+        return max();
+    }
+    
+    // {"count":N,"meanUs":..,"p50Us":..,"p90Us":..,"p99Us":..,"p999Us":..,"maxUs":..}
+    // plus, with buckets, the non-empty ones as [upperUs, count] pairs
+    void writeJson(JsonWriter& out, bool buckets = false) const {
+        out.raw("{\"count\":").integer(static_cast<long long>(count()))
+           .raw(",\"meanUs\":").number(mean() / 1000)
+           .raw(",\"p50Us\":").number(percentile(0.50) / 1000.0)
+           .raw(",\"p90Us\":").number(percentile(0.90) / 1000.0)
+           .raw(",\"p99Us\":").number(percentile(0.99) / 1000.0)
+           .raw(",\"p999Us\":").number(percentile(0.999) / 1000.0)
+           .raw(",\"maxUs\":").number(max() / 1000.0);
+        if (buckets) {
+            out.raw(",\"buckets\":[");
+            bool first = true;
+            for (int i = 0; i < BUCKET_COUNT; i++) {
+                uint64_t c = counts[i].load(std::memory_order_relaxed);
+                if (c == 0) continue;
+                if (!first) out.raw(',');
+                first = false;
+                out.raw('[').number(bucketUpper(i) / 1000.0).raw(',').integer(static_cast<long long>(c)).raw(']');
+            }
+            out.raw(']');
+        }
+        out.raw('}');
+    }
+};
+
+// Records the time from construction to destruction into a histogram
+// (nothing when metrics are off, or for a null histogram)
+class ScopedTimer {
+private:
+    LatencyHistogram* target;
+    uint64_t start;
+
+public:
+    explicit ScopedTimer(LatencyHistogram* histogram)
+        : target(metricsEnabled() ? histogram : nullptr), start(target ? monotonicNanos() : 0) {}
+    explicit ScopedTimer(LatencyHistogram& histogram) : ScopedTimer(&histogram) {}
+    
+    ~ScopedTimer() {
+        if (target) target->record(monotonicNanos() - start);
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,383 @@
+// Microbenchmarks for the Individual Data Structures
+// Data Structures & Applications Lab Project
+// ns/op, heap allocations/op and cache misses/op (perf_event_open) per structure operation
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "hashmap.h"
+#include "bst.h"
+#include "heap.h"
+#include "trie.h"
+#include "queue.h"
+#include "stack.h"
+#include "datagen.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// ===== ALLOCATION COUNTING =====
+// Replacing the global operator new counts every heap allocation the
+// structures make (nodes, strings, vectors). Single-threaded binary.
+
+static size_t allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+// Out of line, so the compiler does not pair an inlined free() with the
+// operator new call it sees and warn about a mismatch
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void releaseAllocation(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p) noexcept { releaseAllocation(p); }
+void operator delete[](void* p) noexcept { releaseAllocation(p); }
+void operator delete(void* p, std::size_t) noexcept { releaseAllocation(p); }
+void operator delete[](void* p, std::size_t) noexcept { releaseAllocation(p); }
+
+// ===== CACHE MISS COUNTER =====
+// Hardware cache-miss events of this thread (user space only), when the
+// kernel lets us open them; otherwise the column reads n/a
+
+class CacheMissCounter {
+private:
+    int fd;
+
+public:
+    CacheMissCounter() : fd(-1) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+    
+    bool available() const { return fd >= 0; }
+    
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    
+    // Misses since start(), or -1 if unavailable
+    long long stop() {
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+};
+
+// ===== HARNESS =====
+
+struct MicroSample {
+    double nsPerOp;
+    double allocsPerOp;
+    double missesPerOp;     // negative = not measured
+};
+
+// Results of a value the optimizer must not drop
+volatile size_t benchSink = 0;
+
+class MicroBench {
+private:
+    std::string filter;
+    std::vector<std::string> order;
+    std::map<std::string, std::vector<MicroSample>> samples;
+    std::map<std::string, size_t> opCounts;
+    CacheMissCounter misses;
+
+public:
+    explicit MicroBench(const std::string& f) : filter(f) {}
+    
+    bool wants(const std::string& label) const {
+        return filter.empty() || label.find(filter) != std::string::npos;
+    }
+    
+    // Time ops operations done by body(); setup belongs outside
+    template<typename F>
+    void measure(const std::string& label, size_t ops, F body) {
+        if (!wants(label)) return;
+        size_t allocsBefore = allocationCount;
+        misses.start();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        long long missCount = misses.stop();
+        size_t allocs = allocationCount - allocsBefore;
+        
+        if (!samples.count(label)) order.push_back(label);
+        opCounts[label] = ops;
+        samples[label].push_back(MicroSample{ns / ops, static_cast<double>(allocs) / ops,
+                                             missCount >= 0 ? static_cast<double>(missCount) / ops : -1.0});
+    }
+    
+    // Median round of each case, by time
+    void report() {
+        std::cout << std::left << std::setw(36) << "case" << std::right << std::setw(10) << "ops"
+                  << std::setw(14) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(14)
+                  << "misses/op" << std::endl;
+        for (const auto& label : order) {
+            std::vector<MicroSample>& runs = samples[label];
+            std::sort(runs.begin(), runs.end(), [](const MicroSample& a, const MicroSample& b) {
+                return a.nsPerOp < b.nsPerOp;
+            });
+            const MicroSample& median = runs[runs.size() / 2];
+            std::cout << std::left << std::setw(36) << label << std::right << std::setw(10) << opCounts[label]
+                      << std::fixed << std::setprecision(1) << std::setw(14) << median.nsPerOp
+                      << std::setprecision(2) << std::setw(12) << median.allocsPerOp << std::setw(14);
+            if (median.missesPerOp >= 0) std::cout << median.missesPerOp;
+            else std::cout << "n/a";
+            std::cout << std::endl;
+        }
+        if (!misses.available()) {
+            std::cout << "(cache misses need perf_event_open: Linux with kernel.perf_event_paranoid <= 2)"
+                      << std::endl;
+        }
+    }
+};
+
+// ===== INPUTS =====
+// Deterministic, shared by every round and every implementation compared
+
+struct MicroInputs {
+    std::vector<std::string> keys;          // distinct
+    std::vector<std::string> missingKeys;
+    std::vector<size_t> probeOrder;         // random permutation of keys
+    std::vector<Transaction> randomDated;
+    std::vector<Transaction> sortedDated;
+    std::vector<std::pair<std::string, std::string>> ranges;   // 30-day windows
+    std::vector<std::string> words;
+    std::vector<std::string> prefixes;
+    std::vector<Bill> bills;
+    
+    MicroInputs(size_t n, uint64_t seed) {
+        SplitMix64 rng(seed);
+        long long endDay = daysFromCivil(2025, 12, 31);
+        
+        for (size_t i = 0; i < n; i++) {
+            keys.push_back("key_" + std::to_string(rng.next() % 1000000000ull) + "_" + std::to_string(i));
+            missingKeys.push_back("absent_" + std::to_string(i));
+            probeOrder.push_back(i);
+        }
+        for (size_t i = n; i > 1; i--) std::swap(probeOrder[i - 1], probeOrder[rng.below(i)]);
+        
+        for (size_t i = 0; i < n; i++) {
+            const GenCategory& category = GEN_EXPENSE_CATEGORIES[rng.below(GEN_EXPENSE_COUNT)];
+            randomDated.push_back(Transaction("txn_" + std::to_string(i), "expense",
+                                              generateAmount(rng, category.median), category.name,
+                                              category.payees[rng.below(4)],
+                                              civilFromDays(endDay - static_cast<long long>(rng.below(3 * 365)))));
+        }
+        for (size_t i = 0; i < 1000; i++) {
+            long long start = endDay - static_cast<long long>(rng.below(3 * 365));
+            ranges.push_back(std::make_pair(civilFromDays(start), civilFromDays(start + 30)));
+        }
+        sortedDated = randomDated;
+        std::sort(sortedDated.begin(), sortedDated.end(), [](const Transaction& a, const Transaction& b) {
+            return a.date < b.date;
+        });
+        
+        // Autocomplete vocabulary: lowercase words of 4-12 letters
+        for (size_t i = 0; i < std::max<size_t>(n / 10, 100); i++) {
+            std::string word;
+            size_t length = 4 + rng.below(9);
+            for (size_t c = 0; c < length; c++) word += static_cast<char>('a' + rng.below(26));
+            words.push_back(word);
+        }
+        for (size_t i = 0; i < 10000; i++) {
+            const std::string& word = words[rng.below(words.size())];
+            prefixes.push_back(word.substr(0, 1 + rng.below(3)));
+        }
+        
+        for (size_t i = 0; i < std::max<size_t>(n / 10, 100); i++) {
+            Bill b;
+            b.id = "bill_" + std::to_string(i);
+            b.name = "Bill " + std::to_string(i);
+            b.amount = generateAmount(rng, 80);
+            b.dueDate = civilFromDays(endDay - 60 + static_cast<long long>(rng.below(120)));
+            b.category = "Utilities";
+            b.isPaid = rng.below(10) < 3;
+            bills.push_back(b);
+        }
+    }
+};
+
+// ===== CASES =====
+// Each case is a template over the structure, so a replacement can be
+// benchmarked on the same inputs by instantiating it with another type
+// offering the same operations.
+
+template<typename Map>
+void benchHashMap(MicroBench& bench, const MicroInputs& in) {
+    Map map;
+    bench.measure("HashMap insert", in.keys.size(), [&] {
+        for (size_t i = 0; i < in.keys.size(); i++) map.insert(in.keys[i], static_cast<double>(i));
+    });
+    
+    double value;
+    size_t found = 0;
+    bench.measure("HashMap search (hit)", in.keys.size(), [&] {
+        for (size_t i : in.probeOrder) found += map.search(in.keys[i], value);
+    });
+    bench.measure("HashMap search (miss)", in.missingKeys.size(), [&] {
+        for (const auto& key : in.missingKeys) found += map.search(key, value);
+    });
+    benchSink = benchSink + found;
+}
+
+template<typename Tree>
+void benchBst(MicroBench& bench, const MicroInputs& in) {
+    {
+        Tree tree;
+        bench.measure("BST insert (random dates)", in.randomDated.size(), [&] {
+            for (const auto& t : in.randomDated) tree.insert(t);
+        });
+        size_t total = 0;
+        bench.measure("BST rangeQuery (30 days)", in.ranges.size(), [&] {
+            for (const auto& range : in.ranges) total += tree.rangeQuery(range.first, range.second).size();
+        });
+        benchSink = benchSink + total;
+    }
+    {
+        Tree tree;
+        bench.measure("BST insert (sorted dates)", in.sortedDated.size(), [&] {
+            for (const auto& t : in.sortedDated) tree.insert(t);
+        });
+    }
+}
+
+template<typename Heap>
+void benchMaxHeap(MicroBench& bench, const MicroInputs& in) {
+    Heap heap;
+    bench.measure("MaxHeap buildHeap", in.randomDated.size(), [&] {
+        heap.buildHeap(in.randomDated);
+    });
+    
+    const size_t calls = std::max<size_t>(10, 1000000 / in.randomDated.size());
+    size_t total = 0;
+    bench.measure("MaxHeap getTopK(10)", calls, [&] {
+        for (size_t i = 0; i < calls; i++) total += heap.getTopK(10).size();
+    });
+    benchSink = benchSink + total;
+}
+
+template<typename TrieType>
+void benchTrie(MicroBench& bench, const MicroInputs& in) {
+    TrieType trie;
+    bench.measure("Trie insert", in.words.size(), [&] {
+        for (const auto& w : in.words) trie.insert(w);
+    });
+    
+    size_t total = 0;
+    bench.measure("Trie getWordsWithPrefix(10)", in.prefixes.size(), [&] {
+        for (const auto& p : in.prefixes) total += trie.getWordsWithPrefix(p, 10).size();
+    });
+    benchSink = benchSink + total;
+}
+
+template<typename Queue>
+void benchBillQueue(MicroBench& bench, const MicroInputs& in) {
+    Queue queue;
+    bench.measure("BillQueue enqueue", in.bills.size(), [&] {
+        for (const auto& b : in.bills) queue.enqueue(b);
+    });
+    
+    const size_t calls = 100;
+    size_t total = 0;
+    bench.measure("BillQueue getOverdueBills", calls, [&] {
+        for (size_t i = 0; i < calls; i++) total += queue.getOverdueBills("2025-12-31").size();
+    });
+    benchSink = benchSink + total;
+}
+
+template<typename Stack>
+void benchUndoStack(MicroBench& bench, const MicroInputs& in) {
+    const int capacity = 50;    // FinanceEngine's undo depth
+    Stack stack(capacity);
+    for (int i = 0; i < capacity; i++) stack.push(Action(ADD_TRANSACTION, in.keys[i % in.keys.size()]));
+    
+    // Every push now evicts the oldest action
+    bench.measure("UndoStack push (at capacity)", in.keys.size(), [&] {
+        for (const auto& key : in.keys) stack.push(Action(ADD_TRANSACTION, key));
+    });
+    benchSink = benchSink + stack.size();
+}
+
+int main(int argc, char* argv[]) {
+    // Parse arguments: [--n N] [--rounds R] [--seed N] [--filter TEXT]
+    size_t n = 50000;
+    int rounds = 5;
+    uint64_t seed = 42;
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--n" && i + 1 < argc) {
+            n = std::max<size_t>(100, static_cast<size_t>(std::strtod(argv[++i], nullptr)));
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+    }
+    
+    MicroInputs inputs(n, seed);
+    MicroBench bench(filter);
+    for (int round = 0; round < rounds; round++) {
+        benchHashMap<HashMap<double>>(bench, inputs);
+        benchBst<BST>(bench, inputs);
+        benchMaxHeap<MaxHeap>(bench, inputs);
+        benchTrie<Trie>(bench, inputs);
+        benchBillQueue<BillQueue>(bench, inputs);
+        benchUndoStack<UndoStack>(bench, inputs);
+    }
+    
+    std::cout << "n = " << n << ", median of " << rounds << " rounds" << std::endl;
+    bench.report();
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Perfect Hash Implementation for Compile-Time Keyword Lookup
+// Data Structures & Applications Lab Project
+// Operations: constexpr seed search over a fixed key set, O(1) lookup
+
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// Seeded FNV-1a with a final mix, usable in constant expressions
+constexpr uint32_t seededHash(std::string_view key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Maps each key of a fixed set to its own slot (no collisions), so a lookup
+// is one hash plus one string compare. SLOTS must be a power of two.
+template<size_t SLOTS>
+class PerfectHash {
+private:
+    static_assert(SLOTS > 0 && (SLOTS & (SLOTS - 1)) == 0, "SLOTS must be a power of two");
+    
+    uint32_t seed;
+    int16_t slots[SLOTS];  // index of the key in its table, -1 = empty
+    bool valid;
+
+public:
+    constexpr PerfectHash() : seed(0), slots(), valid(false) {
+        for (size_t i = 0; i < SLOTS; i++) slots[i] = -1;
+    }
+    
+    // Try seeds until every key lands in a distinct slot. Entries need a
+    // std::string_view `name` member.
+    // Time Complexity: O(n * key length) per seed tried
+    template<typename Entry, size_t N>
+    static constexpr PerfectHash build(const Entry (&entries)[N], uint32_t maxSeeds = 1u << 16) {
+        static_assert(N <= SLOTS, "more keys than slots");
+        PerfectHash table;
+        for (uint32_t seed = 0; seed < maxSeeds; seed++) {
+            for (size_t i = 0; i < SLOTS; i++) table.slots[i] = -1;
+            
+            bool collision = false;
+            for (size_t i = 0; i < N && !collision; i++) {
+                size_t slot = seededHash(entries[i].name, seed) & (SLOTS - 1);
+                if (table.slots[slot] >= 0) {
+                    collision = true;
+                } else {
+                    table.slots[slot] = static_cast<int16_t>(i);
+                }
+            }
+            if (!collision) {
+                table.seed = seed;
+                table.valid = true;
+                return table;
+            }
+        }
+        return table;
+    }
+    
+    // Index of the only key that can equal key, or -1; the caller compares
+    // names, since a key outside the set also maps to some slot
+    // Time Complexity: O(key length)
+    constexpr int candidate(std::string_view key) const {
+        return slots[seededHash(key, seed) & (SLOTS - 1)];
+    }
+    
+    constexpr bool isValid() const { return valid; }
+};
+
+#endif // PERFECT_HASH_H
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include "memory_usage.h"
 
 struct Bill {
     std::string id;
@@ -38,6 +39,16 @@ private:
 public:
     BillQueue() : front(nullptr), rear(nullptr), count(0) {}
     
+    // Deep copy, same order
+    // Time Complexity: O(n)
+    BillQueue(const BillQueue& other) : front(nullptr), rear(nullptr), count(0) {
+        for (QueueNode* node = other.front; node; node = node->next) {
+            enqueue(node->data);
+        }
+    }
+    
+    BillQueue& operator=(const BillQueue&) = delete;
+    
     ~BillQueue() {
         while (front) {
             QueueNode* temp = front;
@@ -189,6 +200,19 @@ public:
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
     
+    // Node count and footprint
+    // Time Complexity: O(n)
+    ContainerStats stats() const {
+        ContainerStats s;
+        for (QueueNode* node = front; node; node = node->next) {
+            const Bill& b = node->data;
+            s.size++;
+            s.bytes += sizeof(QueueNode) + stringHeapBytes(b.id) + stringHeapBytes(b.name) +
+                       stringHeapBytes(b.dueDate) + stringHeapBytes(b.category);
+        }
+        return s;
+    }
+    
     void clear() {
         while (front) {
             QueueNode* temp = front;
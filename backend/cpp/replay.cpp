@@ -0,0 +1,353 @@
+// Replay of a Captured Command Log Against the Finance Engine
+// Data Structures & Applications Lab Project
+// Re-runs a --capture session on a fresh data directory at full speed, times every command
+// and checks each response against the checksum recorded when it was captured
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <ctime>
+#include "json_reader.h"
+#include "checksum.h"
+#include "fileutil.h"
+#include "bench_support.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#ifndef _WIN32
+// ===== CAPTURE FILE =====
+
+struct CapturedRequest {
+    std::string request;
+    std::string command;    // "batch" for envelopes
+    long long timeUs;       // wall clock when the engine received it
+    double micros;          // time the engine took to answer it then
+    uint32_t crc;           // CRC-32C of the response line
+};
+
+std::string commandOf(const std::string& request) {
+    JsonFields fields;
+    if (!fields.parse(request)) return "(invalid)";
+    if (fields.get("batch").kind == JsonValue::ARRAY) return "batch";
+    std::string command = fields.getString("command");
+    return command.empty() ? "(invalid)" : command;
+}
+
+// Time Complexity: O(file size)
+bool loadCapture(const std::string& path, std::vector<CapturedRequest>& records, size_t& skipped) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    JsonFields fields;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        // A record cut off by a crash is the last line; skip it (and anything else unreadable)
+        if (!fields.parse(line) || !fields.has("request") || !fields.has("crc")) {
+            skipped++;
+            continue;
+        }
+        CapturedRequest r;
+        r.request = fields.getString("request");
+        r.command = commandOf(r.request);
+        r.timeUs = static_cast<long long>(fields.getDouble("timeUs"));
+        r.micros = fields.getDouble("us");
+        r.crc = static_cast<uint32_t>(std::strtoul(fields.getString("crc").c_str(), nullptr, 16));
+        records.push_back(std::move(r));
+    }
+    return true;
+}
+
+// ===== ID MAPPING =====
+// The engine names new records "txn_<unix seconds>_<n>" / "bill_<unix
+// seconds>_<n>", with n counting from 1 in each process. A replay creates
+// the same records in the same order, so it gets the same n but a later
+// timestamp. The ids are mapped both ways: captured ids in requests become
+// the replayed ones, and replayed ids in responses are turned back into the
+// captured ones (the second the request arrived) before checksumming.
+
+class IdMap {
+private:
+    long long replayStart;  // ids stamped at or after this second were created by the replay
+    std::unordered_map<std::string, std::string> toReplayed;
+    std::unordered_map<std::string, std::string> toCaptured;
+    
+    // Length of an engine id starting at text[at], or 0
+    static size_t idLength(const std::string& text, size_t at, size_t& stampAt, size_t& counterAt) {
+        size_t i = at;
+        if (text.compare(i, 4, "txn_") == 0) i += 4;
+        else if (text.compare(i, 5, "bill_") == 0) i += 5;
+        else return 0;
+        if (at > 0 && (std::isalnum(static_cast<unsigned char>(text[at - 1])) || text[at - 1] == '_')) return 0;
+        
+        stampAt = i;
+        while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) i++;
+        if (i == stampAt || i >= text.size() || text[i] != '_') return 0;
+        counterAt = ++i;
+        while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) i++;
+        if (i == counterAt) return 0;
+        if (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) return 0;
+        return i - at;
+    }
+    
+    // Copy text, passing every engine id through replace(id, stampAt, counterAt)
+    // Time Complexity: O(text length)
+    template<typename F>
+    static std::string rewrite(const std::string& text, F replace) {
+        std::string result;
+        size_t copied = 0;
+        for (size_t at = text.find_first_of("tb"); at != std::string::npos; at = text.find_first_of("tb", at + 1)) {
+            size_t stampAt = 0, counterAt = 0;
+            size_t length = idLength(text, at, stampAt, counterAt);
+            if (length == 0) continue;
+            result.append(text, copied, at - copied);
+            result += replace(text.substr(at, length), stampAt - at, counterAt - at);
+            copied = at + length;
+            at = copied - 1;
+        }
+        if (copied == 0) return text;
+        result.append(text, copied, std::string::npos);
+        return result;
+    }
+
+public:
+    IdMap() : replayStart(static_cast<long long>(std::time(nullptr))) {}
+    
+    std::string toReplay(const std::string& request) const {
+        return rewrite(request, [&](const std::string& id, size_t, size_t) {
+            auto it = toReplayed.find(id);
+            return it == toReplayed.end() ? id : it->second;
+        });
+    }
+    
+    // Learn the ids the replay created while answering a request captured at
+    // capturedSecond, and return the response with the captured ids in place
+    std::string toCapture(const std::string& response, long long capturedSecond) {
+        return rewrite(response, [&](const std::string& id, size_t stampAt, size_t counterAt) {
+            auto it = toCaptured.find(id);
+            if (it != toCaptured.end()) return it->second;
+            if (std::atoll(id.c_str() + stampAt) < replayStart) return id;   // loaded from the data
+            
+            std::string captured = id.substr(0, stampAt) + std::to_string(capturedSecond) + id.substr(counterAt - 1);
+            toCaptured.emplace(id, captured);
+            toReplayed.emplace(captured, id);
+            return captured;
+        });
+    }
+};
+
+// ===== REPLAY =====
+
+struct ReplayOptions {
+    std::string capturePath;
+    std::string engine;
+    std::string workDir;
+    std::string fromDir;        // copied as the starting data directory
+    std::string tenantsDir;     // copied as the tenant root
+    std::string csvPath;
+    bool verify;
+    size_t showMismatches;
+    std::vector<std::string> engineArgs;
+    
+    ReplayOptions() : engine("./finance_engine"), workDir("replay_data"), verify(true), showMismatches(5) {}
+};
+
+struct CommandReport {
+    std::vector<double> samples;
+    std::vector<double> captured;
+    size_t mismatches;
+    
+    CommandReport() : mismatches(0) {}
+};
+
+// Responses that report on the process itself, not on the data
+bool isVolatile(const std::string& command) {
+    return command == "get_metrics" || command == "get_engine_stats";
+}
+
+// Fresh copy of the starting state, so a replay never changes its input
+bool prepareWorkDir(const ReplayOptions& options, std::string& dataDir, std::string& tenantRoot) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    dataDir = options.workDir + "/data";
+    fs::remove_all(dataDir, error);
+    if (!ensureDirectory(options.workDir)) return false;
+    if (options.fromDir.empty()) {
+        if (!ensureDirectory(dataDir)) return false;
+    } else {
+        fs::copy(options.fromDir, dataDir, fs::copy_options::recursive, error);
+        if (error) return false;
+    }
+    
+    if (!options.tenantsDir.empty()) {
+        tenantRoot = options.workDir + "/tenants";
+        fs::remove_all(tenantRoot, error);
+        fs::copy(options.tenantsDir, tenantRoot, fs::copy_options::recursive, error);
+        if (error) return false;
+    }
+    return true;
+}
+
+void printReport(const std::string& command, CommandReport& report, bool verify) {
+    std::sort(report.samples.begin(), report.samples.end());
+    std::sort(report.captured.begin(), report.captured.end());
+    std::cout << std::left << std::setw(28) << command << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << report.samples.size()
+              << std::setw(12) << percentile(report.samples, 0.50)
+              << std::setw(12) << percentile(report.samples, 0.99)
+              << std::setw(12) << report.samples.back()
+              << std::setw(14) << percentile(report.captured, 0.50);
+    if (verify) std::cout << std::setw(12) << (isVolatile(command) ? "-" : std::to_string(report.mismatches));
+    std::cout << std::endl;
+}
+
+bool writeCsv(const std::string& path, const std::map<std::string, CommandReport>& reports) {
+    std::ofstream csv(path);
+    if (!csv) return false;
+    csv << "command,count,p50_us,p99_us,max_us,captured_p50_us,mismatches\n";
+    for (const auto& entry : reports) {
+        const CommandReport& r = entry.second;
+        csv << "\"" << entry.first << "\"," << r.samples.size() << "," << percentile(r.samples, 0.50) << ","
+            << percentile(r.samples, 0.99) << "," << r.samples.back() << "," << percentile(r.captured, 0.50)
+            << "," << r.mismatches << "\n";
+    }
+    return static_cast<bool>(csv);
+}
+
+int replay(const ReplayOptions& options) {
+    std::vector<CapturedRequest> records;
+    size_t skipped = 0;
+    if (!loadCapture(options.capturePath, records, skipped)) {
+        std::cerr << "Error: cannot read " << options.capturePath << std::endl;
+        return 1;
+    }
+    if (skipped > 0) std::cerr << "Warning: skipped " << skipped << " unreadable capture lines" << std::endl;
+    if (records.empty()) {
+        std::cerr << "Error: no requests in " << options.capturePath << std::endl;
+        return 1;
+    }
+    
+    std::string dataDir, tenantRoot;
+    if (!prepareWorkDir(options, dataDir, tenantRoot)) {
+        std::cerr << "Error: cannot set up " << options.workDir << std::endl;
+        return 1;
+    }
+    
+    IdMap ids;  // before the engine starts: everything it stamps is a replay id
+    std::vector<std::string> args = {dataDir, "--serve"};
+    if (!tenantRoot.empty()) {
+        args.push_back("--tenant-root");
+        args.push_back(tenantRoot);
+    }
+    args.insert(args.end(), options.engineArgs.begin(), options.engineArgs.end());
+    EngineProcess engine;
+    if (!engine.start(options.engine, args)) {
+        std::cerr << "Error: cannot start " << options.engine << std::endl;
+        return 1;
+    }
+    
+    std::map<std::string, CommandReport> reports;
+    size_t mismatches = 0;
+    std::string response;
+    Clock::time_point begin = Clock::now();
+    for (size_t i = 0; i < records.size(); i++) {
+        const CapturedRequest& record = records[i];
+        std::string request = ids.toReplay(record.request);
+        Clock::time_point start = Clock::now();
+        if (!engine.request(request, response)) {
+            std::cerr << "Error: engine stopped at request " << (i + 1) << " (" << record.command << ")" << std::endl;
+            return 1;
+        }
+        double micros = elapsedMicros(start);
+        
+        CommandReport& report = reports[record.command];
+        report.samples.push_back(micros);
+        report.captured.push_back(record.micros);
+        std::string normalized = ids.toCapture(response, record.timeUs / 1000000);
+        if (!options.verify || isVolatile(record.command)) continue;
+        
+        if (crc32c(normalized.data(), normalized.size()) == record.crc) continue;
+        report.mismatches++;
+        if (++mismatches <= options.showMismatches) {
+            std::cerr << "Mismatch at request " << (i + 1) << " (" << record.command << "): "
+                      << record.request.substr(0, 200) << "\n  replayed: " << response.substr(0, 200) << std::endl;
+        }
+    }
+    double total = elapsedMicros(begin);
+    int status = engine.finish();
+    
+    std::cout << std::left << std::setw(28) << "command" << std::right << std::setw(8) << "count"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us"
+              << std::setw(14) << "captured p50";
+    if (options.verify) std::cout << std::setw(12) << "mismatches";
+    std::cout << std::endl;
+    for (auto& entry : reports) printReport(entry.first, entry.second, options.verify);
+    
+    double capturedSpan = (records.back().timeUs - records.front().timeUs) / 1e6;
+    std::cout << std::fixed << std::setprecision(2) << "\n" << records.size() << " requests replayed in "
+              << total / 1e6 << " s (" << std::setprecision(0) << records.size() / (total / 1e6)
+              << " req/s); the captured session spanned " << std::setprecision(2) << capturedSpan << " s" << std::endl;
+    if (options.verify) std::cout << mismatches << " responses differed from the capture" << std::endl;
+    
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, reports)) {
+        std::cerr << "Error: cannot write " << options.csvPath << std::endl;
+        return 1;
+    }
+    if (status != 0) {
+        std::cerr << "Error: engine exited with status " << status << std::endl;
+        return 1;
+    }
+    return mismatches > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Parse arguments: CAPTURE [--engine PATH] [--work DIR] [--from DATA_DIR]
+    // [--tenants TENANT_ROOT] [--no-verify] [--show N] [--csv FILE] [-- engine flags...]
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc) {
+            options.engine = argv[++i];
+        } else if (arg == "--work" && i + 1 < argc) {
+            options.workDir = argv[++i];
+        } else if (arg == "--from" && i + 1 < argc) {
+            options.fromDir = argv[++i];
+        } else if (arg == "--tenants" && i + 1 < argc) {
+            options.tenantsDir = argv[++i];
+        } else if (arg == "--no-verify") {
+            options.verify = false;
+        } else if (arg == "--show" && i + 1 < argc) {
+            options.showMismatches = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--") {
+            options.engineArgs.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (options.capturePath.empty()) {
+            options.capturePath = arg;
+        }
+    }
+    if (options.capturePath.empty()) {
+        std::cerr << "Usage: finance_replay CAPTURE [--from DATA_DIR] [--engine PATH] [-- engine flags...]" << std::endl;
+        return 1;
+    }
+    
+    signal(SIGPIPE, SIG_IGN);   // a crashed engine shows up as a failed write
+    return replay(options);
+}
+
+#else
+int main() {
+    std::cerr << "finance_replay needs POSIX pipes and fork; it is not supported on this platform" << std::endl;
+    return 1;
+}
+#endif
@@ -0,0 +1,446 @@
+// Binary Snapshot Format for Fast Engine Startup
+// Data Structures & Applications Lab Project
+// One file per collection: header, fixed-width records, string table, checksum
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include "finance_engine.h"
+#include "checksum.h"
+#include "fileutil.h"
+
+// File layout (host byte order, little-endian on every supported target):
+//
+//   SnapshotHeader | records[recordCount] | string table | uint32 CRC-32C
+//
+// Records are fixed width and refer to their text through StrRef slices of
+// the string table, so loading is one sequential read plus a checksum pass,
+// with no text parsing. Repeated strings (types, categories, dates) are
+// stored once.
+
+const char SNAPSHOT_MAGIC[4] = {'F', 'E', 'S', 'N'};
+const uint16_t SNAPSHOT_VERSION = 1;
+
+enum SnapshotKind : uint16_t {
+    SNAPSHOT_TRANSACTIONS = 1,
+    SNAPSHOT_BUDGETS = 2,       // budgets plus per-category expense totals
+    SNAPSHOT_BILLS = 3,
+    SNAPSHOT_UNDO = 4
+};
+
+enum SnapshotStatus {
+    SNAPSHOT_OK,
+    SNAPSHOT_MISSING,
+    SNAPSHOT_CORRUPT
+};
+
+struct SnapshotHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t kind;
+    uint32_t recordCount;
+    uint32_t recordSize;
+    uint32_t stringBytes;
+    uint32_t reserved;
+};
+
+struct StrRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct TransactionRecord {
+    double amount;
+    StrRef id;
+    StrRef type;
+    StrRef category;
+    StrRef description;
+    StrRef date;
+};
+
+// Category flags for CategoryRecord (neither set: a category name only)
+const uint32_t CATEGORY_HAS_BUDGET = 1;
+const uint32_t CATEGORY_HAS_TOTAL = 2;
+
+struct CategoryRecord {
+    double limit;
+    double expenseTotal;
+    StrRef category;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct BillRecord {
+    double amount;
+    StrRef id;
+    StrRef name;
+    StrRef dueDate;
+    StrRef category;
+    uint32_t isPaid;
+    uint32_t reserved;
+};
+
+struct UndoRecord {
+    StrRef data;
+    uint32_t type;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 24, "snapshot header layout");
+static_assert(sizeof(TransactionRecord) == 48, "transaction record layout");
+static_assert(sizeof(CategoryRecord) == 32, "category record layout");
+static_assert(sizeof(BillRecord) == 48, "bill record layout");
+static_assert(sizeof(UndoRecord) == 16, "undo record layout");
+
+// Builds one snapshot file in memory
+class SnapshotWriter {
+private:
+    std::string records;
+    std::string strings;
+    std::unordered_map<std::string, StrRef> interned;
+    uint32_t count;
+    
+public:
+    SnapshotWriter() : count(0) {}
+    
+    // Add a string to the string table (deduplicated)
+    // Time Complexity: O(m) average where m is the string length
+    StrRef intern(const std::string& s) {
+        auto it = interned.find(s);
+        if (it != interned.end()) return it->second;
+        
+        StrRef ref = {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size())};
+        strings += s;
+        interned.emplace(s, ref);
+        return ref;
+    }
+    
+    template<typename R>
+    void add(const R& record) {
+        records.append(reinterpret_cast<const char*>(&record), sizeof(R));
+        count++;
+    }
+    
+    // Returns the number of bytes written, or 0 on failure
+    size_t writeTo(const std::string& path, SnapshotKind kind, uint32_t recordSize) const {
+        SnapshotHeader header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+        header.version = SNAPSHOT_VERSION;
+        header.kind = kind;
+        header.recordCount = count;
+        header.recordSize = recordSize;
+        header.stringBytes = static_cast<uint32_t>(strings.size());
+        header.reserved = 0;
+        
+        std::string data;
+        data.reserve(sizeof(header) + records.size() + strings.size() + sizeof(uint32_t));
+        data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        data += records;
+        data += strings;
+        uint32_t crc = crc32c(data.data(), data.size());
+        data.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        
+        return writeFileAtomic(path, data) ? data.size() : 0;
+    }
+};
+
+// Reads and verifies one snapshot file
+class SnapshotReader {
+private:
+    std::string buffer;
+    SnapshotHeader header;
+    size_t stringStart;
+    
+public:
+    SnapshotReader() : stringStart(0) {
+        std::memset(&header, 0, sizeof(header));
+    }
+    
+    // Load the whole file and check magic, version, kind, sizes and checksum
+    // Time Complexity: O(file size)
+    SnapshotStatus open(const std::string& path, SnapshotKind kind, uint32_t recordSize) {
+        if (!readFile(path, buffer)) return SNAPSHOT_MISSING;
+        if (buffer.size() < sizeof(SnapshotHeader) + sizeof(uint32_t)) {
+            return SNAPSHOT_CORRUPT;
+        }
+        
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 ||
+            header.version != SNAPSHOT_VERSION || header.kind != kind ||
+            header.recordSize != recordSize) {
+            return SNAPSHOT_CORRUPT;
+        }
+        
+        uint64_t expected = sizeof(SnapshotHeader) + (uint64_t)header.recordCount * recordSize +
+                            header.stringBytes + sizeof(uint32_t);
+        if (expected != buffer.size()) return SNAPSHOT_CORRUPT;
+        
+        uint32_t stored;
+        size_t payload = buffer.size() - sizeof(uint32_t);
+        std::memcpy(&stored, buffer.data() + payload, sizeof(stored));
+        if (crc32c(buffer.data(), payload) != stored) return SNAPSHOT_CORRUPT;
+        
+        stringStart = sizeof(SnapshotHeader) + (size_t)header.recordCount * recordSize;
+        return SNAPSHOT_OK;
+    }
+    
+    uint32_t recordCount() const { return header.recordCount; }
+    
+    template<typename R>
+    R record(uint32_t index) const {
+        R r;
+        std::memcpy(&r, buffer.data() + sizeof(SnapshotHeader) + (size_t)index * sizeof(R), sizeof(R));
+        return r;
+    }
+    
+    // Slice of the string table (valid while the reader lives)
+    std::string_view str(const StrRef& ref) const {
+        if ((uint64_t)ref.offset + ref.length > header.stringBytes) return std::string_view();
+        return std::string_view(buffer.data() + stringStart + ref.offset, ref.length);
+    }
+};
+
+// ===== PER-COLLECTION SNAPSHOTS =====
+// save* functions return the bytes written (0 on failure)
+
+inline size_t saveTransactionsSnapshot(const FinanceEngine& engine, const std::string& path) {
+    SnapshotWriter writer;
+    for (const auto& t : engine.getAllTransactions()) {
+        TransactionRecord r;
+        r.amount = t.amount;
+        r.id = writer.intern(t.id);
+        r.type = writer.intern(t.type);
+        r.category = writer.intern(t.category);
+        r.description = writer.intern(t.description);
+        r.date = writer.intern(t.date);
+        writer.add(r);
+    }
+    return writer.writeTo(path, SNAPSHOT_TRANSACTIONS, sizeof(TransactionRecord));
+}
+
+inline SnapshotStatus loadTransactionsSnapshot(FinanceEngine& engine, const std::string& path) {
+    SnapshotReader reader;
+    SnapshotStatus status = reader.open(path, SNAPSHOT_TRANSACTIONS, sizeof(TransactionRecord));
+    if (status != SNAPSHOT_OK) return status;
+    
+    for (uint32_t i = 0; i < reader.recordCount(); i++) {
+        TransactionRecord r = reader.record<TransactionRecord>(i);
+        engine.loadTransaction(reader.str(r.id), reader.str(r.type), r.amount,
+                               reader.str(r.category), reader.str(r.description),
+                               reader.str(r.date));
+    }
+    return SNAPSHOT_OK;
+}
+
+// Budgets are stored together with the pre-aggregated expense totals, so the
+// totals (and each budget's spent amount) survive without the transactions
+inline size_t saveBudgetsSnapshot(const FinanceEngine& engine, const std::string& path) {
+    std::unordered_map<std::string, CategoryRecord> byCategory;
+    std::vector<std::string> order;
+    
+    auto recordFor = [&](const std::string& category) -> CategoryRecord& {
+        auto it = byCategory.find(category);
+        if (it == byCategory.end()) {
+            CategoryRecord r;
+            std::memset(&r, 0, sizeof(r));
+            it = byCategory.emplace(category, r).first;
+            order.push_back(category);
+        }
+        return it->second;
+    };
+    
+    for (const auto& pair : engine.getExpenseTotals()) {
+        CategoryRecord& r = recordFor(pair.first);
+        r.expenseTotal = pair.second;
+        r.flags |= CATEGORY_HAS_TOTAL;
+    }
+    for (const auto& b : engine.getAllBudgets()) {
+        CategoryRecord& r = recordFor(b.category);
+        r.limit = b.limit;
+        r.flags |= CATEGORY_HAS_BUDGET;
+    }
+    // Every other known category, so autocomplete works without the transactions
+    for (const auto& category : engine.getAllCategories()) {
+        recordFor(category);
+    }
+    
+    SnapshotWriter writer;
+    for (const auto& category : order) {
+        CategoryRecord r = byCategory[category];
+        r.category = writer.intern(category);
+        writer.add(r);
+    }
+    return writer.writeTo(path, SNAPSHOT_BUDGETS, sizeof(CategoryRecord));
+}
+
+inline SnapshotStatus loadBudgetsSnapshot(FinanceEngine& engine, const std::string& path) {
+    SnapshotReader reader;
+    SnapshotStatus status = reader.open(path, SNAPSHOT_BUDGETS, sizeof(CategoryRecord));
+    if (status != SNAPSHOT_OK) return status;
+    
+    // Totals first, so each budget picks up its spent amount
+    for (uint32_t i = 0; i < reader.recordCount(); i++) {
+        CategoryRecord r = reader.record<CategoryRecord>(i);
+        if (r.flags & CATEGORY_HAS_TOTAL) {
+            engine.loadExpenseTotal(reader.str(r.category), r.expenseTotal);
+        }
+    }
+    for (uint32_t i = 0; i < reader.recordCount(); i++) {
+        CategoryRecord r = reader.record<CategoryRecord>(i);
+        if (r.flags & CATEGORY_HAS_BUDGET) {
+            engine.loadBudget(reader.str(r.category), r.limit);
+        } else {
+            engine.loadCategory(reader.str(r.category));
+        }
+    }
+    return SNAPSHOT_OK;
+}
+
+inline size_t saveBillsSnapshot(const FinanceEngine& engine, const std::string& path) {
+    SnapshotWriter writer;
+    for (const auto& b : engine.getAllBills()) {
+        BillRecord r;
+        r.amount = b.amount;
+        r.id = writer.intern(b.id);
+        r.name = writer.intern(b.name);
+        r.dueDate = writer.intern(b.dueDate);
+        r.category = writer.intern(b.category);
+        r.isPaid = b.isPaid ? 1 : 0;
+        r.reserved = 0;
+        writer.add(r);
+    }
+    return writer.writeTo(path, SNAPSHOT_BILLS, sizeof(BillRecord));
+}
+
+inline SnapshotStatus loadBillsSnapshot(FinanceEngine& engine, const std::string& path) {
+    SnapshotReader reader;
+    SnapshotStatus status = reader.open(path, SNAPSHOT_BILLS, sizeof(BillRecord));
+    if (status != SNAPSHOT_OK) return status;
+    
+    for (uint32_t i = 0; i < reader.recordCount(); i++) {
+        BillRecord r = reader.record<BillRecord>(i);
+        engine.loadBill(reader.str(r.id), reader.str(r.name), r.amount,
+                        reader.str(r.dueDate), reader.str(r.category), r.isPaid != 0);
+    }
+    return SNAPSHOT_OK;
+}
+
+// Undo actions are stored top of stack first, like undo_stack.json
+inline size_t saveUndoSnapshot(const FinanceEngine& engine, const std::string& path) {
+    SnapshotWriter writer;
+    for (const auto& a : engine.getUndoActions()) {
+        UndoRecord r;
+        r.data = writer.intern(a.data);
+        r.type = static_cast<uint32_t>(a.type);
+        r.reserved = 0;
+        writer.add(r);
+    }
+    return writer.writeTo(path, SNAPSHOT_UNDO, sizeof(UndoRecord));
+}
+
+inline SnapshotStatus loadUndoSnapshot(FinanceEngine& engine, const std::string& path) {
+    SnapshotReader reader;
+    SnapshotStatus status = reader.open(path, SNAPSHOT_UNDO, sizeof(UndoRecord));
+    if (status != SNAPSHOT_OK) return status;
+    
+    // Push bottom first so the stack ends up in the saved order
+    for (uint32_t i = reader.recordCount(); i-- > 0; ) {
+        UndoRecord r = reader.record<UndoRecord>(i);
+        engine.loadUndoAction(static_cast<ActionType>(r.type), reader.str(r.data));
+    }
+    return SNAPSHOT_OK;
+}
+
+// ===== MANIFEST =====
+// A checkpoint writes fresh snapshot files named after the last log sequence
+// they include, then switches to them by atomically replacing the manifest.
+// A crash part-way through leaves the previous manifest, its files and the
+// full log in place.
+
+// Indexed by Collection (finance_engine.h)
+const char* const COLLECTION_NAMES[COLLECTION_COUNT] = {
+    "transactions", "budgets", "bills", "undo_stack"
+};
+
+struct SnapshotManifest {
+    uint64_t sequence;                      // Last log record folded into the files
+    uint64_t snapshotBytes;                 // Total size of the snapshot files
+    std::string files[COLLECTION_COUNT];    // Snapshot file per collection
+    uint64_t fileBytes[COLLECTION_COUNT];   // Size of each file (0 if unknown)
+    
+    SnapshotManifest() : sequence(0), snapshotBytes(0) {
+        for (int i = 0; i < COLLECTION_COUNT; i++) fileBytes[i] = 0;
+    }
+};
+
+inline std::string manifestPath(const std::string& dataDir) {
+    return dataDir + "/snapshot.manifest";
+}
+
+inline std::string snapshotFileName(int collection, uint64_t sequence) {
+    return std::string(COLLECTION_NAMES[collection]) + "-" + std::to_string(sequence) + ".snap";
+}
+
+inline bool writeManifest(const std::string& dataDir, const SnapshotManifest& manifest) {
+    std::string text = "FESM " + std::to_string(SNAPSHOT_VERSION) + "\n";
+    text += "sequence " + std::to_string(manifest.sequence) + "\n";
+    text += "bytes " + std::to_string(manifest.snapshotBytes) + "\n";
+    for (int i = 0; i < COLLECTION_COUNT; i++) {
+        text += std::string(COLLECTION_NAMES[i]) + " " + manifest.files[i] + " " +
+                std::to_string(manifest.fileBytes[i]) + "\n";
+    }
+    text += "crc " + std::to_string(crc32c(text.data(), text.size())) + "\n";
+    return writeFileAtomic(manifestPath(dataDir), text);
+}
+
+inline SnapshotStatus readManifest(const std::string& dataDir, SnapshotManifest& manifest) {
+    std::string text;
+    if (!readFile(manifestPath(dataDir), text)) return SNAPSHOT_MISSING;
+    
+    size_t crcLine = text.rfind("crc ");
+    if (crcLine == std::string::npos) return SNAPSHOT_CORRUPT;
+    if (std::to_string(crc32c(text.data(), crcLine)) + "\n" != text.substr(crcLine + 4)) {
+        return SNAPSHOT_CORRUPT;
+    }
+    
+    std::istringstream in(text.substr(0, crcLine));
+    std::string word;
+    int version = 0;
+    if (!(in >> word >> version) || word != "FESM" || version != SNAPSHOT_VERSION) {
+        return SNAPSHOT_CORRUPT;
+    }
+    
+    // Lines are "<key> <value>", or "<collection> <file> [bytes]"
+    int found = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string value;
+        if (!(fields >> word >> value)) continue;
+        
+        if (word == "sequence") {
+            manifest.sequence = std::stoull(value);
+        } else if (word == "bytes") {
+            manifest.snapshotBytes = std::stoull(value);
+        } else {
+            for (int i = 0; i < COLLECTION_COUNT; i++) {
+                if (word == COLLECTION_NAMES[i]) {
+                    manifest.files[i] = value;
+                    fields >> manifest.fileBytes[i];
+                    found++;
+                }
+            }
+        }
+    }
+    return found == COLLECTION_COUNT ? SNAPSHOT_OK : SNAPSHOT_CORRUPT;
+}
+
+#endif // SNAPSHOT_H
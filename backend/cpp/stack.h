@@ -44,6 +44,18 @@ private:
 public:
     UndoStack(int maxSz = 50) : top(nullptr), count(0), maxSize(maxSz) {}
     
+    // Deep copy, same order
+    // Time Complexity: O(n)
+    UndoStack(const UndoStack& other) : top(nullptr), count(other.count), maxSize(other.maxSize) {
+        StackNode** link = &top;
+        for (StackNode* node = other.top; node; node = node->next) {
+            *link = new StackNode(node->data);
+            link = &(*link)->next;
+        }
+    }
+    
+    UndoStack& operator=(const UndoStack&) = delete;
+    
     ~UndoStack() {
         while (top) {
             StackNode* temp = top;
@@ -112,6 +124,17 @@ public:
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
     
+    // Node count and footprint
+    // Time Complexity: O(n)
+    ContainerStats stats() const {
+        ContainerStats s;
+        for (StackNode* node = top; node; node = node->next) {
+            s.size++;
+            s.bytes += sizeof(StackNode) + stringHeapBytes(node->data.data);
+        }
+        return s;
+    }
+    
     void clear() {
         while (top) {
             StackNode* temp = top;
@@ -141,6 +164,19 @@ private:
 public:
     TransactionStack(int maxSz = 100) : topNode(nullptr), count(0), maxSize(maxSz), top(nullptr) {}
     
+    // Deep copy, same order
+    // Time Complexity: O(n)
+    TransactionStack(const TransactionStack& other)
+        : topNode(nullptr), count(other.count), maxSize(other.maxSize), top(nullptr) {
+        TStackNode** link = &top;
+        for (TStackNode* node = other.top; node; node = node->next) {
+            *link = new TStackNode(node->data);
+            link = &(*link)->next;
+        }
+    }
+    
+    TransactionStack& operator=(const TransactionStack&) = delete;
+    
     ~TransactionStack() {
         while (top) {
             TStackNode* temp = top;
@@ -191,6 +227,23 @@ public:
         return true;
     }
     
+    // Drop a transaction that was deleted
+    // Time Complexity: O(n), n <= maxSize
+    bool removeById(const std::string& id) {
+        TStackNode** link = &top;
+        while (*link) {
+            if ((*link)->data.id == id) {
+                TStackNode* temp = *link;
+                *link = temp->next;
+                delete temp;
+                count--;
+                return true;
+            }
+            link = &(*link)->next;
+        }
+        return false;
+    }
+    
     std::vector<Transaction> getAll() const {
         std::vector<Transaction> result;
         TStackNode* current = top;
@@ -218,6 +271,17 @@ public:
     int size() const { return count; }
     bool isEmpty() const { return count == 0; }
     
+    // Node count and footprint
+    // Time Complexity: O(n)
+    ContainerStats stats() const {
+        ContainerStats s;
+        for (TStackNode* node = top; node; node = node->next) {
+            s.size++;
+            s.bytes += sizeof(TStackNode) + transactionHeapBytes(node->data);
+        }
+        return s;
+    }
+    
     void clear() {
         while (top) {
             TStackNode* temp = top;
@@ -0,0 +1,216 @@
+// Chrome Trace Recording of Engine Operations (opt-in)
+// Data Structures & Applications Lab Project
+// Operations: scoped spans, lock-free per-thread span buffers, Chrome trace JSON export
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "metrics.h"
+#include "json_writer.h"
+#include "fileutil.h"
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    std::string detail;     // e.g. the file a persistence span read or wrote
+    uint64_t start;         // monotonic ns
+    uint64_t duration;
+};
+
+// One thread's spans. Only that thread appends; the exporter reads the
+// published prefix (count, release/acquire), so recording takes no lock.
+// Events live in fixed-size chunks allocated as needed, which never move.
+class TraceBuffer {
+public:
+    static const size_t CHUNK_EVENTS = 4096;
+    static const size_t MAX_CHUNKS = 256;   // ~1M spans per thread; later ones are dropped
+
+private:
+    std::atomic<TraceEvent*> chunks[MAX_CHUNKS];
+    std::atomic<size_t> count;
+    std::atomic<uint64_t> dropped;
+    std::atomic<const char*> name;
+    int id;
+
+public:
+    explicit TraceBuffer(int threadId) : count(0), dropped(0), name(nullptr), id(threadId) {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+    
+    // Owner thread only
+    // Time Complexity: O(1) amortized
+    void append(const char* category, const char* spanName, const std::string& detail,
+                uint64_t start, uint64_t duration) {
+        size_t n = count.load(std::memory_order_relaxed);
+        size_t chunk = n / CHUNK_EVENTS;
+        if (chunk >= MAX_CHUNKS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        TraceEvent* events = chunks[chunk].load(std::memory_order_relaxed);
+        if (!events) {
+            events = new TraceEvent[CHUNK_EVENTS];
+            chunks[chunk].store(events, std::memory_order_release);
+        }
+        TraceEvent& e = events[n % CHUNK_EVENTS];
+        e.category = category;
+        e.name = spanName;
+        e.detail = detail;
+        e.start = start;
+        e.duration = duration;
+        count.store(n + 1, std::memory_order_release);
+    }
+    
+    // Readable from any thread
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    const TraceEvent& at(size_t i) const {
+        return chunks[i / CHUNK_EVENTS].load(std::memory_order_acquire)[i % CHUNK_EVENTS];
+    }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    int threadId() const { return id; }
+    
+    const char* threadName() const { return name.load(std::memory_order_relaxed); }
+    void setThreadName(const char* threadName) { name.store(threadName, std::memory_order_relaxed); }
+};
+
+// Process-wide recorder: off unless started (--trace PATH or FINANCE_TRACE).
+// Each thread gets its buffer on its first span; buffers stay allocated
+// until the process exits, since a detached thread may record until then.
+class Tracer {
+private:
+    std::atomic<bool> enabled;
+    std::mutex registry;    // guards buffers; taken once per thread, and to export
+    std::vector<TraceBuffer*> buffers;
+    std::string path;
+    uint64_t origin;
+    
+    Tracer() : enabled(false), origin(0) {}
+
+public:
+    static Tracer& instance() {
+        static Tracer* tracer = new Tracer();  // never destroyed, see above
+        return *tracer;
+    }
+    
+    // Call before the threads that should be traced start
+    void start(const std::string& tracePath) {
+        path = tracePath;
+        origin = monotonicNanos();
+        enabled.store(true, std::memory_order_relaxed);
+    }
+    
+    bool active() const { return enabled.load(std::memory_order_relaxed); }
+    
+    TraceBuffer& threadBuffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> guard(registry);
+            buffer = new TraceBuffer(static_cast<int>(buffers.size()) + 1);
+            buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+    
+    // Label the calling thread in the trace viewer
+    void nameThread(const char* threadName) {
+        if (active()) threadBuffer().setThreadName(threadName);
+    }
+    
+    // Write {"traceEvents":[...]} (Chrome trace event format, complete "X"
+    // events in microseconds) through path.tmp. Spans still being recorded
+    // by other threads are left out.
+    // Time Complexity: O(spans)
+    bool write() {
+        if (!active()) return true;
+        std::lock_guard<std::mutex> guard(registry);
+        std::string tmpPath = path + ".tmp";
+        FILE* file = std::fopen(tmpPath.c_str(), "wb");
+        if (!file) return false;
+        
+        JsonWriter out;
+        out.setSink(file);
+        out.raw("{\"traceEvents\":[");
+        bool first = true;
+        bool ok = true;
+        uint64_t dropped = 0;
+        for (const TraceBuffer* buffer : buffers) {
+            dropped += buffer->droppedCount();
+            const char* threadName = buffer->threadName();
+            if (threadName) {
+                if (!first) out.raw(',');
+                first = false;
+                out.raw("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":").integer(buffer->threadId())
+                   .raw(",\"args\":{\"name\":").string(threadName).raw("}}");
+            }
+            
+            size_t n = buffer->size();
+            for (size_t i = 0; i < n && ok; i++) {
+                const TraceEvent& e = buffer->at(i);
+                if (!first) out.raw(',');
+                first = false;
+                out.raw("\n{\"name\":").string(e.name)
+                   .raw(",\"cat\":").string(e.category)
+                   .raw(",\"ph\":\"X\",\"ts\":").number((e.start - origin) / 1000.0)
+                   .raw(",\"dur\":").number(e.duration / 1000.0)
+                   .raw(",\"pid\":1,\"tid\":").integer(buffer->threadId());
+                if (!e.detail.empty()) out.raw(",\"args\":{\"detail\":").string(e.detail).raw('}');
+                out.raw('}');
+                ok = out.drain();
+            }
+        }
+        out.raw("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedSpans\":")
+           .integer(static_cast<long long>(dropped)).raw("}}\n");
+        ok = out.flushTo(file) && ok;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        return replaceFile(tmpPath, path);
+    }
+};
+
+inline Tracer& tracer() { return Tracer::instance(); }
+
+// Records one span from construction to destruction on the calling thread
+// (nothing unless tracing is on). Spans opened inside it nest under it in
+// the viewer. category and name must be string literals (or otherwise
+// outlive the process); detail is copied.
+class TraceSpan {
+private:
+    const char* category;
+    const char* name;
+    std::string detail;
+    uint64_t start;
+
+public:
+    TraceSpan(const char* spanCategory, const char* spanName, std::string_view spanDetail = std::string_view())
+        : category(tracer().active() ? spanCategory : nullptr), name(spanName), start(0) {
+        if (category) {
+            detail.assign(spanDetail.data(), spanDetail.size());
+            start = monotonicNanos();
+        }
+    }
+    
+    ~TraceSpan() {
+        if (category) {
+            uint64_t end = monotonicNanos();
+            tracer().threadBuffer().append(category, name, detail, start, end - start);
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // TRACE_H
@@ -9,6 +9,7 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
+#include "memory_usage.h"
 
 struct TrieNode {
     std::unordered_map<char, TrieNode*> children;
@@ -17,6 +18,15 @@ struct TrieNode {
     
     TrieNode() : isEndOfWord(false) {}
     
+    // Deep copy of the subtree
+    TrieNode(const TrieNode& other) : isEndOfWord(other.isEndOfWord), word(other.word) {
+        for (const auto& pair : other.children) {
+            children[pair.first] = new TrieNode(*pair.second);
+        }
+    }
+    
+    TrieNode& operator=(const TrieNode&) = delete;
+    
     ~TrieNode() {
         for (auto& pair : children) {
             delete pair.second;
@@ -24,11 +34,35 @@ struct TrieNode {
     }
 };
 
+// Node counts and footprint (see Trie::stats)
+struct TrieStats {
+    int nodes;
+    int words;
+    int deadNodes;      // nodes with no word left below them (remove keeps nodes)
+    size_t bytes;       // nodes, their child maps and stored words
+    
+    TrieStats() : nodes(0), words(0), deadNodes(0), bytes(0) {}
+};
+
 class Trie {
 private:
     TrieNode* root;
     int wordCount;
     
+    // Helper: Accumulate stats for a subtree; true if a word ends in it
+    bool statsHelper(const TrieNode* node, TrieStats& s) const {
+        s.nodes++;
+        s.bytes += sizeof(TrieNode) + stringHeapBytes(node->word) +
+                   node->children.bucket_count() * sizeof(void*) +
+                   node->children.size() * (sizeof(void*) + sizeof(std::pair<const char, TrieNode*>));
+        bool live = node->isEndOfWord;
+        for (const auto& pair : node->children) {
+            if (statsHelper(pair.second, s)) live = true;
+        }
+        if (!live && node != root) s.deadNodes++;
+        return live;
+    }
+    
     // Helper: Collect all words from a given node
     void collectWords(TrieNode* node, std::vector<std::string>& result) const {
         if (!node) return;
@@ -54,6 +88,12 @@ public:
         root = new TrieNode();
     }
     
+    // Deep copy
+    // Time Complexity: O(total characters)
+    Trie(const Trie& other) : root(new TrieNode(*other.root)), wordCount(other.wordCount) {}
+    
+    Trie& operator=(const Trie&) = delete;
+    
     ~Trie() {
         delete root;
     }
@@ -180,6 +220,14 @@ public:
     int size() const { return wordCount; }
     bool isEmpty() const { return wordCount == 0; }
     
+    // Time Complexity: O(nodes)
+    TrieStats stats() const {
+        TrieStats s;
+        statsHelper(root, s);
+        s.words = wordCount;
+        return s;
+    }
+    
     void clear() {
         delete root;
         root = new TrieNode();
@@ -0,0 +1,556 @@
+// Append-Only Write-Ahead Log of Engine Mutations
+// Data Structures & Applications Lab Project
+// Operations: append, sync (inline or group commit), replay, reset
+
+#ifndef WAL_H
+#define WAL_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "finance_engine.h"
+#include "checksum.h"
+#include "fileutil.h"
+
+
+// Record layout (host byte order):
+//
+//   uint32 bodyLength | uint32 CRC-32C of body | body
+//   body = uint64 sequence | uint8 MutationType | fields
+//
+// Strings are written as uint32 length + bytes, amounts as raw doubles.
+// A record whose length or checksum does not match marks a torn write at
+// the end of the log; replay stops there. An intact record after a bad one
+// means the log was damaged in the middle, and replay refuses it.
+
+class WalEncoder {
+private:
+    std::string& out;
+    
+public:
+    WalEncoder(std::string& o) : out(o) {}
+    
+    void u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+    void u64(uint64_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void f64(double v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    
+    void str(const std::string& s) {
+        uint32_t length = static_cast<uint32_t>(s.size());
+        out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        out += s;
+    }
+};
+
+class WalDecoder {
+private:
+    const char* p;
+    const char* end;
+    bool ok;
+    bool skipStrings;  // check string lengths only, without copying
+    
+    bool take(void* dst, size_t n) {
+        if (!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return false;
+        }
+        std::memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+    
+public:
+    WalDecoder(const char* data, size_t length, bool skip = false)
+        : p(data), end(data + length), ok(true), skipStrings(skip) {}
+    
+    uint8_t u8() { uint8_t v = 0; take(&v, sizeof(v)); return v; }
+    uint64_t u64() { uint64_t v = 0; take(&v, sizeof(v)); return v; }
+    double f64() { double v = 0; take(&v, sizeof(v)); return v; }
+    
+    std::string str() {
+        uint32_t length = 0;
+        if (!take(&length, sizeof(length)) || (size_t)(end - p) < length) {
+            ok = false;
+            return "";
+        }
+        const char* start = p;
+        p += length;
+        return skipStrings ? std::string() : std::string(start, length);
+    }
+    
+    bool valid() const { return ok && p == end; }
+};
+
+// Encode one mutation as a complete, checksummed record
+inline void encodeWalRecord(uint64_t sequence, const Mutation& m, std::string& out) {
+    std::string body;
+    WalEncoder enc(body);
+    enc.u64(sequence);
+    enc.u8(static_cast<uint8_t>(m.type));
+    
+    switch (m.type) {
+        case MUT_ADD_TRANSACTION:
+            enc.str(m.transaction.id);
+            enc.str(m.transaction.type);
+            enc.f64(m.transaction.amount);
+            enc.str(m.transaction.category);
+            enc.str(m.transaction.description);
+            enc.str(m.transaction.date);
+            break;
+        case MUT_SET_BUDGET:
+            enc.str(m.key);
+            enc.f64(m.value);
+            break;
+        case MUT_ADD_BILL:
+            enc.str(m.bill.id);
+            enc.str(m.bill.name);
+            enc.f64(m.bill.amount);
+            enc.str(m.bill.dueDate);
+            enc.str(m.bill.category);
+            break;
+        case MUT_DELETE_TRANSACTION:
+        case MUT_PAY_BILL:
+        case MUT_DELETE_BILL:
+            enc.str(m.key);
+            break;
+        case MUT_UNDO:
+        case MUT_CLEAR_UNDO:
+            break;
+    }
+    
+    uint32_t length = static_cast<uint32_t>(body.size());
+    uint32_t crc = crc32c(body.data(), body.size());
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    out += body;
+}
+
+// Decode a record body; returns false if it is malformed. With shapeOnly
+// the strings are left empty, so the check is O(fields), not O(length).
+inline bool decodeWalBody(const char* data, size_t length, uint64_t& sequence, Mutation& m,
+                          bool shapeOnly = false) {
+    WalDecoder dec(data, length, shapeOnly);
+    sequence = dec.u64();
+    uint8_t type = dec.u8();
+    if (type < MUT_ADD_TRANSACTION || type > MUT_CLEAR_UNDO) return false;
+    m = Mutation(static_cast<MutationType>(type));
+    
+    switch (m.type) {
+        case MUT_ADD_TRANSACTION:
+            m.transaction.id = dec.str();
+            m.transaction.type = dec.str();
+            m.transaction.amount = dec.f64();
+            m.transaction.category = dec.str();
+            m.transaction.description = dec.str();
+            m.transaction.date = dec.str();
+            break;
+        case MUT_SET_BUDGET:
+            m.key = dec.str();
+            m.value = dec.f64();
+            break;
+        case MUT_ADD_BILL:
+            m.bill.id = dec.str();
+            m.bill.name = dec.str();
+            m.bill.amount = dec.f64();
+            m.bill.dueDate = dec.str();
+            m.bill.category = dec.str();
+            break;
+        case MUT_DELETE_TRANSACTION:
+        case MUT_PAY_BILL:
+        case MUT_DELETE_BILL:
+            m.key = dec.str();
+            break;
+        case MUT_UNDO:
+        case MUT_CLEAR_UNDO:
+            break;
+    }
+    return dec.valid();
+}
+
+struct WalEntry {
+    uint64_t sequence;
+    Mutation mutation;
+};
+
+enum WalStatus {
+    WAL_OK,       // every record intact, or only a torn tail
+    WAL_MISSING,  // no log file
+    WAL_CORRUPT   // a bad record with intact ones after it
+};
+
+// Decode the record at pos if its length and checksum hold; next is the
+// offset after it
+inline bool readWalRecord(const std::string& data, size_t pos, WalEntry& entry, size_t& next) {
+    const size_t headerSize = 2 * sizeof(uint32_t);
+    if (data.size() - pos < headerSize) return false;
+    
+    uint32_t length, crc;
+    std::memcpy(&length, data.data() + pos, sizeof(length));
+    std::memcpy(&crc, data.data() + pos + sizeof(length), sizeof(crc));
+    if (data.size() - pos - headerSize < length) return false;
+    
+    const char* body = data.data() + pos + headerSize;
+    if (crc32c(body, length) != crc) return false;
+    if (!decodeWalBody(body, length, entry.sequence, entry.mutation)) return false;
+    next = pos + headerSize + length;
+    return true;
+}
+
+// Cheap test (no checksum) that pos could start a record written after
+// lastSequence: the length fits the data, and the body's field lengths add
+// up to exactly that length (checked without copying the strings)
+inline bool couldBeLaterRecord(const std::string& data, size_t pos, uint64_t lastSequence) {
+    const size_t headerSize = 2 * sizeof(uint32_t);
+    if (data.size() - pos < headerSize) return false;
+    
+    uint32_t length;
+    std::memcpy(&length, data.data() + pos, sizeof(length));
+    if (data.size() - pos - headerSize < length) return false;
+    
+    uint64_t sequence;
+    Mutation m;
+    return decodeWalBody(data.data() + pos + headerSize, length, sequence, m, true) &&
+           sequence > lastSequence;
+}
+
+// Read every intact record of a log file, in order.
+// validBytes is the length of the intact prefix. What follows it is a torn
+// write unless a later record (higher sequence) still decodes: a crash only
+// tears the end, so that is damage, and replaying around the hole would
+// silently drop mutations. The damage scan checksums only the offsets whose
+// fields line up as a record (see couldBeLaterRecord).
+// Time Complexity: O(log size), plus one checksum per offset that lines up
+inline WalStatus readWal(const std::string& path, std::vector<WalEntry>& entries, size_t& validBytes) {
+    validBytes = 0;
+    std::string data;
+    if (!readFile(path, data)) return WAL_MISSING;
+    
+    size_t pos = 0;
+    uint64_t lastSequence = 0;
+    WalEntry entry;
+    size_t next;
+    while (pos < data.size() && readWalRecord(data, pos, entry, next)) {
+        lastSequence = entry.sequence;
+        entries.push_back(entry);
+        pos = next;
+    }
+    validBytes = pos;
+    
+    for (size_t scan = pos + 1; scan < data.size(); scan++) {
+        if (couldBeLaterRecord(data, scan, lastSequence) && readWalRecord(data, scan, entry, next) &&
+            entry.sequence > lastSequence) {
+            return WAL_CORRUPT;
+        }
+    }
+    return WAL_OK;
+}
+
+// Appends mutation records to the log file and makes them durable
+class WalFlusher;
+
+// Appends records to the log. Without a flusher, sync() writes and fsyncs
+// inline. With one (group commit), sync() only hands the buffered records to
+// the flusher thread, which writes the records of many commands with one
+// fsync; waitDurable() blocks until a record is on disk.
+class WalWriter {
+private:
+    FILE* file;
+    std::string path;
+    uint64_t nextSequence;
+    std::atomic<size_t> bytes;  // written; read by size() without ioMutex
+    
+    // Records not written yet, and the last sequence among them. Guarded by
+    // bufferMutex, so appends never wait for a write in progress.
+    std::string pending;
+    uint64_t pendingSequence;
+    std::mutex bufferMutex;
+    
+    // File writes and fsyncs, and everything that replaces the file
+    std::mutex ioMutex;
+    
+    // Highest sequence known to be on disk, and whether a write failed since
+    // the last open/reset. A failed write may leave a torn record, so nothing
+    // more is appended after it (later records would read as corruption);
+    // only a checkpoint (reset) makes the log usable again.
+    uint64_t durableSequence;
+    bool failed;
+    std::mutex durableMutex;
+    std::condition_variable durableChanged;
+    
+    WalFlusher* flusher;
+    
+    void markDurable(uint64_t sequence) {
+        {
+            std::lock_guard<std::mutex> guard(durableMutex);
+            if (sequence > durableSequence) durableSequence = sequence;
+        }
+        durableChanged.notify_all();
+    }
+    
+    void setFailed(bool value) {
+        std::lock_guard<std::mutex> guard(durableMutex);
+        failed = value;
+    }
+    
+public:
+    WalWriter() : file(nullptr), nextSequence(1), bytes(0), pendingSequence(0),
+                  durableSequence(0), failed(false), flusher(nullptr) {}
+    
+    ~WalWriter() {
+        close();
+    }
+    
+    WalWriter(const WalWriter&) = delete;
+    WalWriter& operator=(const WalWriter&) = delete;
+    
+    // Hand syncs to a background flusher (group commit); set before open()
+    void useFlusher(WalFlusher* f) { flusher = f; }
+    
+    // Open the log for appending, cutting off any torn tail first
+    bool open(const std::string& logPath, uint64_t firstSequence, size_t validBytes) {
+        close();
+        std::lock_guard<std::mutex> io(ioMutex);
+        path = logPath;
+        nextSequence = firstSequence;
+        markDurable(firstSequence - 1);
+        setFailed(false);
+        
+        file = std::fopen(path.c_str(), "r+b");
+        if (!file) file = std::fopen(path.c_str(), "a+b");  // creates it; never truncates
+        if (!file) return false;
+        
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        if (size > (long)validBytes) {
+            // Cut off the torn tail in place (rare: only after a crash mid-append);
+            // the acknowledged records before it are never rewritten
+            if (!truncateFile(file, validBytes)) {
+                std::fclose(file);
+                file = nullptr;
+                return false;
+            }
+        }
+        std::fseek(file, 0, SEEK_END);
+        bytes = validBytes;
+        return true;
+    }
+    
+    // Buffer one mutation; it becomes durable on the next sync()
+    // Time Complexity: O(record size), independent of history size
+    void append(const Mutation& m) {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        pendingSequence = nextSequence;
+        encodeWalRecord(nextSequence++, m, pending);
+    }
+    
+    // Make the buffered records durable: inline, or by scheduling them with
+    // the flusher (then wait with waitDurable(lastSequence()))
+    bool sync();
+    
+    // Write and fsync whatever is buffered. Called by sync() or the flusher.
+    // After a failure the records are dropped unwritten (see failed).
+    bool flush() {
+        std::lock_guard<std::mutex> io(ioMutex);
+        std::string batch;
+        uint64_t batchSequence;
+        {
+            std::lock_guard<std::mutex> guard(bufferMutex);
+            batch.swap(pending);
+            batchSequence = pendingSequence;
+        }
+        if (batch.empty()) return !hasFailed();
+        if (!file || hasFailed()) {
+            setFailed(true);
+            markDurable(batchSequence);  // nothing more will come of them
+            return false;
+        }
+        
+        bool ok = std::fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+        if (ok) bytes += batch.size();
+        ok = syncFile(file) && ok;
+        // Waiters are released on failure too; waitDurable tells them
+        if (!ok) setFailed(true);
+        markDurable(batchSequence);
+        return ok;
+    }
+    
+    // Block until the record with this sequence has been written; false
+    // when the log failed instead (the caller must checkpoint or report it)
+    bool waitDurable(uint64_t sequence) {
+        std::unique_lock<std::mutex> guard(durableMutex);
+        durableChanged.wait(guard, [&] { return durableSequence >= sequence; });
+        return !failed;
+    }
+    
+    bool hasFailed() {
+        std::lock_guard<std::mutex> guard(durableMutex);
+        return failed;
+    }
+    
+    // Drop every record, written or buffered (after a checkpoint has folded
+    // them into the snapshots, which makes the buffered ones durable too)
+    bool reset() {
+        std::lock_guard<std::mutex> io(ioMutex);
+        {
+            std::lock_guard<std::mutex> guard(bufferMutex);
+            pending.clear();
+        }
+        markDurable(nextSequence - 1);
+        if (file) std::fclose(file);
+        file = std::fopen(path.c_str(), "w+b");
+        bool ok = file && syncFile(file);
+        bytes = 0;
+        setFailed(!ok);
+        return ok;
+    }
+    
+    void close();
+    
+    uint64_t lastSequence() const { return nextSequence - 1; }
+    
+    // Bytes in the log, counting records not written yet
+    size_t size() {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        return bytes + pending.size();
+    }
+    
+    bool isOpen() const { return file != nullptr; }
+};
+
+// Group commit: one background thread writes and fsyncs the logs that have
+// buffered records. It waits up to the commit window after the first record
+// arrives, so the records of every command in that window share one fsync.
+// A window of 0 adds no delay; records that pile up during an fsync still
+// share the next one.
+class WalFlusher {
+private:
+    std::chrono::microseconds window;
+    std::vector<WalWriter*> scheduled;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread worker;
+    
+    // Held for each round of flushes, so cancel() can wait one out
+    std::mutex roundMutex;
+    
+    uint64_t rounds;   // fsync rounds so far
+    uint64_t flushes;  // log writes so far (one per scheduled log per round)
+    
+    void run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(mutex);
+                wake.wait(guard, [this] { return stopping || !scheduled.empty(); });
+                if (scheduled.empty()) return;  // stopping, nothing left
+                
+                if (window.count() > 0 && !stopping) {
+                    // Let more commands join this round
+                    wake.wait_for(guard, window, [this] { return stopping; });
+                }
+            }
+            
+            // Lock order: roundMutex, then mutex (as in cancel)
+            std::lock_guard<std::mutex> round(roundMutex);
+            std::vector<WalWriter*> batch;
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                batch.swap(scheduled);
+            }
+            
+            for (WalWriter* wal : batch) {
+                if (!wal->flush()) {
+                    std::fprintf(stderr, "Warning: failed to write the log in a group commit\n");
+                }
+            }
+            
+            std::lock_guard<std::mutex> guard(mutex);
+            rounds++;
+            flushes += batch.size();
+        }
+    }
+    
+public:
+    explicit WalFlusher(std::chrono::microseconds commitWindow)
+        : window(commitWindow), stopping(false), rounds(0), flushes(0) {
+        worker = std::thread([this] { run(); });
+    }
+    
+    // Flushes whatever is still scheduled, then stops the thread
+    ~WalFlusher() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+    
+    WalFlusher(const WalFlusher&) = delete;
+    WalFlusher& operator=(const WalFlusher&) = delete;
+    
+    // Queue a log for the next round (once per round)
+    void schedule(WalWriter* wal) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            for (WalWriter* queued : scheduled) {
+                if (queued == wal) return;
+            }
+            scheduled.push_back(wal);
+        }
+        wake.notify_one();
+    }
+    
+    // Forget a log that is going away, waiting out a round using it
+    void cancel(WalWriter* wal) {
+        std::lock_guard<std::mutex> round(roundMutex);
+        std::lock_guard<std::mutex> guard(mutex);
+        for (size_t i = 0; i < scheduled.size(); i++) {
+            if (scheduled[i] == wal) {
+                scheduled.erase(scheduled.begin() + i);
+                break;
+            }
+        }
+    }
+    
+    uint64_t roundCount() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return rounds;
+    }
+    
+    uint64_t flushCount() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return flushes;
+    }
+};
+
+inline bool WalWriter::sync() {
+    if (!file || hasFailed()) return false;
+    if (!flusher) return flush();
+    
+    bool empty;
+    {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        empty = pending.empty();
+    }
+    if (!empty) flusher->schedule(this);
+    return true;
+}
+
+inline void WalWriter::close() {
+    if (flusher) flusher->cancel(this);
+    flush();
+    std::lock_guard<std::mutex> io(ioMutex);
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+#endif // WAL_H
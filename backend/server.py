@@ -5,11 +5,15 @@ Data Structures & Applications Lab Project
 """
 
 from fastapi import FastAPI, HTTPException, APIRouter
+from fastapi.responses import StreamingResponse
 from fastapi.middleware.cors import CORSMiddleware
 from pydantic import BaseModel, Field
 from typing import List, Optional
 from datetime import datetime, timezone
 import subprocess
+import threading
+import queue
+import tempfile
 import json
 import os
 from pathlib import Path
@@ -35,9 +39,19 @@ app.add_middleware(
 api_router = APIRouter(prefix="/api")
 
 # Paths
-CPP_ENGINE = ROOT_DIR / "cpp" / "finance_engine.exe"
+CPP_ENGINE = ROOT_DIR / "cpp" / ("finance_engine.exe" if os.name == "nt" else "finance_engine")
 DATA_DIR = ROOT_DIR / "data"
 
+# "serve" keeps one resident engine process; "oneshot" spawns one per request
+ENGINE_MODE = os.environ.get("ENGINE_MODE", "serve")
+
+# Seconds to wait for the engine's answer (or its next streamed line) before
+# the engine is killed and the request fails with 504
+ENGINE_TIMEOUT = 10
+
+# A streamed response larger than this is spooled to a temporary file
+STREAM_SPOOL_BYTES = 1 << 20
+
 # Ensure data directory exists
 DATA_DIR.mkdir(exist_ok=True)
 
@@ -111,6 +125,10 @@ class MonthlySummary(BaseModel):
     transactionCount: int
     categoryBreakdown: List[dict]
 
+class EngineCall(BaseModel):
+    command: str
+    params: Optional[dict] = None
+
 class DashboardData(BaseModel):
     balance: float
     totalIncome: float
@@ -123,35 +141,260 @@ class DashboardData(BaseModel):
 
 # ===== C++ Engine Communication =====
 
-def call_cpp_engine(command: str, params: dict = None) -> dict:
-    """Call the C++ finance engine with a command and return the result."""
-    
-    # Build the input JSON
-    input_data = {"command": command}
-    if params:
-        input_data["params"] = params
-    
-    input_json = json.dumps(input_data)
-    
-    try:
-        # Run the C++ executable
-        result = subprocess.run(
-            [str(CPP_ENGINE)],
-            input=input_json,
-            capture_output=True,
+_read_only_commands = None
+
+
+def read_only_commands() -> frozenset:
+    """Commands the engine's list_commands reports as "read" or "snapshot".
+
+    They change nothing, so sending one twice is harmless. Asked once, from
+    a one-shot engine; an engine that cannot answer makes every command
+    count as a write.
+    """
+    global _read_only_commands
+    if _read_only_commands is None:
+        try:
+            commands = json.loads(run_engine_oneshot('{"command":"list_commands"}'))["commands"]
+            _read_only_commands = frozenset(
+                command["name"] for command in commands if command["access"] != "write")
+        except (HTTPException, subprocess.SubprocessError, OSError, ValueError, KeyError, TypeError):
+            return frozenset()
+    return _read_only_commands
+
+
+def is_read_only(input_data: dict) -> bool:
+    """True when the command (or every command of a batch) only reads."""
+    calls = input_data.get("batch", [input_data])
+    read_only = read_only_commands()
+    return all(isinstance(call, dict) and call.get("command") in read_only
+               for call in calls)
+
+
+class EngineUnavailable(Exception):
+    """The engine died while handling a request that is unsafe to resend."""
+
+class ResidentEngine:
+    """A long-lived `finance_engine <dataDir> --serve` process.
+
+    The engine keeps its data structures in memory and answers one JSON line
+    per request line, so requests no longer pay for reloading the data files.
+    """
+
+    def __init__(self):
+        self._proc = None
+        self._lines = None
+        self._lock = threading.Lock()
+
+    def _start(self):
+        # dataDir goes first so an engine built without --serve support still
+        # answers a single command correctly before exiting
+        self._proc = subprocess.Popen(
+            [str(CPP_ENGINE), str(DATA_DIR), "--serve"],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
             text=True,
-            timeout=10,
+            bufsize=1,
             cwd=str(DATA_DIR)
         )
-        
-        if result.returncode != 0:
-            raise HTTPException(
-                status_code=500, 
-                detail=f"C++ engine error: {result.stderr}"
-            )
+        # A reader thread hands over the output line by line, so waiting for
+        # a line can give up at a deadline; "" marks the end of the output
+        self._lines = queue.Queue()
+        threading.Thread(target=pump_lines, args=(self._proc.stdout, self._lines),
+                         daemon=True).start()
+
+    def _stop(self):
+        if self._proc is not None:
+            self._proc.kill()
+            self._proc.wait()
+            try:
+                self._proc.stdin.close()
+            except OSError:
+                pass  # unsent input to a dead process
+            self._proc = None
+
+    def _send(self, line: str):
+        if self._proc is None or self._proc.poll() is not None:
+            self._stop()
+            self._start()
+        self._proc.stdin.write(line + "\n")
+        self._proc.stdin.flush()
+
+    def _readline(self) -> str:
+        try:
+            return self._lines.get(timeout=ENGINE_TIMEOUT)
+        except queue.Empty:
+            # A hung engine would hold up every request behind it; the next
+            # request starts a fresh one
+            self._stop()
+            raise subprocess.TimeoutExpired(str(CPP_ENGINE), ENGINE_TIMEOUT)
+
+    def _roundtrip(self, line: str) -> str:
+        self._send(line)
+        return self._readline()
+
+    def request(self, line: str, input_data: dict) -> str:
+        with self._lock:
+            try:
+                output = self._roundtrip(line)
+            except (BrokenPipeError, OSError):
+                output = ""
+            if not output:
+                # Engine exited (crash or one-shot binary); the next request
+                # restarts it. Only a read is sent again: a mutation may
+                # already be saved, and resending it would apply it twice.
+                self._stop()
+                if not is_read_only(input_data):
+                    raise EngineUnavailable(
+                        "Engine stopped while handling a write; it may or may not have been applied")
+                output = self._roundtrip(line)
+            return output
+
+
+    def stream(self, line: str):
+        """Yield a streamed (NDJSON) response in chunks as the engine writes it.
+
+        A pump thread drains the response under the lock into a StreamSpool
+        and releases the lock once the engine has finished, so a slow client
+        never holds up the requests queued behind it. If the engine fails
+        part way, the stream ends with an {"error":...} line.
+        """
+        spool = StreamSpool()
+        self._lock.acquire()
+        try:
+            self._send(line)
+        except (BrokenPipeError, OSError) as e:
+            self._stop()
+            self._lock.release()
+            spool.close()
+            yield error_line(f"C++ engine error: {e}").encode()
+            return
+        threading.Thread(target=self._pump_stream, args=(spool,), daemon=True).start()
+        yield from spool
+
+    def _pump_stream(self, spool: "StreamSpool"):
+        try:
+            while True:
+                output = self._readline()
+                if not output:
+                    self._stop()
+                    spool.write(error_line("Engine stopped in the middle of a streamed response"))
+                    break
+                spool.write(output)
+                if is_stream_end(output):
+                    break
+        except subprocess.TimeoutExpired:
+            spool.write(error_line("Engine timeout"))
+        finally:
+            spool.close()
+            self._lock.release()
+
+
+class StreamSpool:
+    """Lines written by one thread and read back in chunks by another.
+
+    Kept in memory up to STREAM_SPOOL_BYTES, then in a temporary file. A
+    reader that stops early (the client went away) discards the rest.
+    """
+
+    CHUNK_BYTES = 64 * 1024
+
+    def __init__(self):
+        self._file = tempfile.SpooledTemporaryFile(max_size=STREAM_SPOOL_BYTES)
+        self._changed = threading.Condition()
+        self._written = 0
+        self._closed = False
+        self._abandoned = False
+
+    def write(self, line: str):
+        with self._changed:
+            if self._abandoned:
+                return
+            self._file.seek(self._written)
+            self._file.write(line.encode())
+            self._written = self._file.tell()
+            self._changed.notify()
+
+    def close(self):
+        """No more lines follow."""
+        with self._changed:
+            self._closed = True
+            self._changed.notify()
+
+    def __iter__(self):
+        position = 0
+        try:
+            while True:
+                with self._changed:
+                    while position == self._written and not self._closed:
+                        self._changed.wait()
+                    if position == self._written:
+                        return
+                    self._file.seek(position)
+                    chunk = self._file.read(min(self._written - position, self.CHUNK_BYTES))
+                position += len(chunk)
+                yield chunk
+        finally:
+            with self._changed:
+                self._abandoned = True
+                self._file.close()
+
+
+def pump_lines(stream, lines: queue.Queue):
+    """Move each line of stream into lines, then "" once it ends."""
+    try:
+        with stream:
+            for line in stream:
+                lines.put(line)
+    except (OSError, ValueError):
+        pass
+    lines.put("")
+
+
+def is_stream_end(line: str) -> bool:
+    """A streamed response ends with a {"done":...} trailer or an error."""
+    return line.startswith('{"done":') or line.startswith('{"error":')
+
+
+def error_line(message: str) -> str:
+    """The terminal error line of a stream, in the engine's own format."""
+    return json.dumps({"error": message}, separators=(",", ":")) + "\n"
+
+
+resident_engine = ResidentEngine()
+
+
+def run_engine_oneshot(input_json: str) -> str:
+    """Run a fresh engine process for a single command."""
+    result = subprocess.run(
+        [str(CPP_ENGINE)],
+        input=input_json,
+        capture_output=True,
+        text=True,
+        timeout=ENGINE_TIMEOUT,
+        cwd=str(DATA_DIR)
+    )
+
+    if result.returncode != 0:
+        raise HTTPException(
+            status_code=500, 
+            detail=f"C++ engine error: {result.stderr}"
+        )
+
+    return result.stdout
+
+
+def send_to_engine(input_data: dict) -> dict:
+    """Send one request envelope to the C++ engine and return the parsed result."""
+    input_json = json.dumps(input_data)
+    
+    try:
+        if ENGINE_MODE == "oneshot":
+            output = run_engine_oneshot(input_json)
+        else:
+            output = resident_engine.request(input_json, input_data)
         
         # Parse output JSON
-        output = result.stdout.strip()
+        output = output.strip()
         if not output:
             return {"error": "Empty response from engine"}
         
@@ -159,6 +402,8 @@ def call_cpp_engine(command: str, params: dict = None) -> dict:
         
     except subprocess.TimeoutExpired:
         raise HTTPException(status_code=504, detail="Engine timeout")
+    except EngineUnavailable as e:
+        raise HTTPException(status_code=503, detail=str(e))
     except json.JSONDecodeError as e:
         raise HTTPException(status_code=500, detail=f"Invalid JSON response: {e}")
     except FileNotFoundError:
@@ -166,9 +411,60 @@ def call_cpp_engine(command: str, params: dict = None) -> dict:
             status_code=500, 
             detail="C++ engine not found. Please compile first."
         )
+    except (BrokenPipeError, OSError) as e:
+        raise HTTPException(status_code=500, detail=f"C++ engine error: {e}")
+
+
+def stream_from_engine(input_data: dict):
+    """Yield NDJSON lines from the engine as it produces them."""
+    input_json = json.dumps(input_data)
+    if ENGINE_MODE != "oneshot":
+        yield from resident_engine.stream(input_json)
+        return
+
+    proc = subprocess.Popen(
+        [str(CPP_ENGINE)],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        text=True,
+        cwd=str(DATA_DIR)
+    )
+    try:
+        proc.stdin.write(input_json + "\n")
+        proc.stdin.close()
+        last = ""
+        for line in proc.stdout:
+            last = line
+            yield line
+        if not is_stream_end(last):
+            yield error_line("Engine stopped in the middle of a streamed response")
+    finally:
+        proc.stdout.close()
+        proc.wait()
+
+
+def call_cpp_engine(command: str, params: dict = None) -> dict:
+    """Call the C++ finance engine with a command and return the result."""
+    
+    # Build the input JSON
+    input_data = {"command": command}
+    if params:
+        input_data["params"] = params
+    
+    return send_to_engine(input_data)
+
+
+def call_cpp_engine_batch(calls: List[dict]) -> List[dict]:
+    """Run several commands in one engine round trip (one load, at most one save)."""
+    result = send_to_engine({"batch": calls})
+    if "results" not in result:
+        raise HTTPException(status_code=500, detail=f"C++ engine error: {result}")
+    return result["results"]
 
 
 # ===== API Endpoints =====
+# Endpoints that talk to the engine are plain functions: FastAPI runs them in
+# its threadpool, so a request waiting for the engine never blocks the event loop.
 
 @api_router.get("/")
 async def root():
@@ -188,7 +484,7 @@ async def health():
 # ----- Dashboard -----
 
 @api_router.get("/dashboard", response_model=DashboardData)
-async def get_dashboard():
+def get_dashboard():
     """Get dashboard summary data."""
     result = call_cpp_engine("get_dashboard")
     return result
@@ -197,7 +493,7 @@ async def get_dashboard():
 # ----- Transactions -----
 
 @api_router.post("/transactions", response_model=dict)
-async def add_transaction(transaction: TransactionCreate):
+def add_transaction(transaction: TransactionCreate):
     """Add a new transaction (using Doubly Linked List + BST)."""
     params = {
         "type": transaction.type,
@@ -209,29 +505,55 @@ async def add_transaction(transaction: TransactionCreate):
     result = call_cpp_engine("add_transaction", params)
     return result
 
+def paging_params(limit: Optional[int], cursor: Optional[str]) -> dict:
+    """Optional keyset paging: at most `limit` records after `cursor`."""
+    params = {}
+    if limit:
+        params["limit"] = str(limit)
+    if cursor:
+        params["cursor"] = cursor
+    return params
+
 @api_router.get("/transactions", response_model=dict)
-async def get_transactions():
-    """Get all transactions sorted by date (using BST in-order traversal)."""
-    result = call_cpp_engine("get_transactions")
+def get_transactions(limit: Optional[int] = None, cursor: Optional[str] = None):
+    """Get transactions sorted by date (using BST in-order traversal).
+
+    With `limit`, returns one page plus `nextCursor` for the next call."""
+    result = call_cpp_engine("get_transactions", paging_params(limit, cursor))
     return result
 
+@api_router.get("/transactions/stream")
+async def stream_transactions(start_date: Optional[str] = None, end_date: Optional[str] = None):
+    """Stream transactions as NDJSON (one per line, straight from the BST walk).
+
+    The last line is {"done": true, "count": N}. With both dates, streams that
+    range in ascending order; otherwise all transactions, newest first."""
+    if start_date and end_date:
+        request = {"command": "get_transactions_by_date",
+                   "params": {"startDate": start_date, "endDate": end_date, "stream": True}}
+    else:
+        request = {"command": "get_transactions", "params": {"stream": True}}
+    return StreamingResponse(stream_from_engine(request), media_type="application/x-ndjson")
+
 @api_router.get("/transactions/recent", response_model=dict)
-async def get_recent_transactions(count: int = 10):
+def get_recent_transactions(count: int = 10):
     """Get recent transactions (using Stack - LIFO)."""
     result = call_cpp_engine("get_recent_transactions", {"count": str(count)})
     return result
 
 @api_router.get("/transactions/range", response_model=dict)
-async def get_transactions_by_range(start_date: str, end_date: str):
+def get_transactions_by_range(start_date: str, end_date: str,
+                                    limit: Optional[int] = None, cursor: Optional[str] = None):
     """Get transactions in date range (using BST range query)."""
     result = call_cpp_engine("get_transactions_by_date", {
         "startDate": start_date,
-        "endDate": end_date
+        "endDate": end_date,
+        **paging_params(limit, cursor)
     })
     return result
 
 @api_router.delete("/transactions/{transaction_id}")
-async def delete_transaction(transaction_id: str):
+def delete_transaction(transaction_id: str):
     """Delete a transaction by ID."""
     result = call_cpp_engine("delete_transaction", {"id": transaction_id})
     return result
@@ -240,7 +562,7 @@ async def delete_transaction(transaction_id: str):
 # ----- Budgets -----
 
 @api_router.post("/budgets", response_model=dict)
-async def set_budget(budget: BudgetCreate):
+def set_budget(budget: BudgetCreate):
     """Set budget for a category (using HashMap)."""
     result = call_cpp_engine("set_budget", {
         "category": budget.category,
@@ -249,19 +571,19 @@ async def set_budget(budget: BudgetCreate):
     return result
 
 @api_router.get("/budgets", response_model=dict)
-async def get_budgets():
+def get_budgets():
     """Get all budgets with spending status (from HashMap)."""
     result = call_cpp_engine("get_budgets")
     return result
 
 @api_router.get("/budgets/alerts", response_model=dict)
-async def get_budget_alerts():
+def get_budget_alerts():
     """Get budget alerts (50%, 80%, 100% thresholds)."""
     result = call_cpp_engine("get_alerts")
     return result
 
 @api_router.get("/alerts", response_model=dict)
-async def get_alerts():
+def get_alerts():
     """Get budget alerts - shortcut route (50%, 80%, 100% thresholds)."""
     result = call_cpp_engine("get_alerts")
     return result
@@ -269,7 +591,7 @@ async def get_alerts():
 # ----- Bills -----
 
 @api_router.post("/bills", response_model=dict)
-async def add_bill(bill: BillCreate):
+def add_bill(bill: BillCreate):
     """Add a bill to the payment queue (using Queue - FIFO)."""
     result = call_cpp_engine("add_bill", {
         "name": bill.name,
@@ -280,19 +602,19 @@ async def add_bill(bill: BillCreate):
     return result
 
 @api_router.get("/bills", response_model=dict)
-async def get_bills():
+def get_bills():
     """Get all bills from the queue."""
     result = call_cpp_engine("get_bills")
     return result
 
 @api_router.post("/bills/{bill_id}/pay")
-async def pay_bill(bill_id: str):
+def pay_bill(bill_id: str):
     """Mark a bill as paid."""
     result = call_cpp_engine("pay_bill", {"id": bill_id})
     return result
 
 @api_router.delete("/bills/{bill_id}")
-async def delete_bill(bill_id: str):
+def delete_bill(bill_id: str):
     """Remove a bill from the queue."""
     result = call_cpp_engine("delete_bill", {"id": bill_id})
     return result
@@ -301,19 +623,19 @@ async def delete_bill(bill_id: str):
 # ----- Analytics -----
 
 @api_router.get("/top-expenses", response_model=dict)
-async def get_top_expenses(count: int = 5):
+def get_top_expenses(count: int = 5):
     """Get top expenses (using Max Heap - extract max)."""
     result = call_cpp_engine("get_top_expenses", {"count": str(count)})
     return result
 
 @api_router.get("/top-categories", response_model=dict)
-async def get_top_categories(count: int = 5):
+def get_top_categories(count: int = 5):
     """Get top spending categories (using Category Max Heap)."""
     result = call_cpp_engine("get_top_categories", {"count": str(count)})
     return result
 
 @api_router.get("/monthly-summary", response_model=dict)
-async def get_monthly_summary(month: Optional[str] = None):
+def get_monthly_summary(month: Optional[str] = None):
     """Get monthly summary (using BST month range query)."""
     params = {"month": month} if month else {}
     result = call_cpp_engine("get_monthly_summary", params)
@@ -323,13 +645,13 @@ async def get_monthly_summary(month: Optional[str] = None):
 # ----- Autocomplete -----
 
 @api_router.get("/categories/suggest", response_model=dict)
-async def get_category_suggestions(prefix: str = ""):
+def get_category_suggestions(prefix: str = ""):
     """Get category suggestions (using Trie prefix search)."""
     result = call_cpp_engine("get_category_suggestions", {"prefix": prefix})
     return result
 
 @api_router.get("/categories", response_model=dict)
-async def get_all_categories():
+def get_all_categories():
     """Get all available categories."""
     result = call_cpp_engine("get_all_categories")
     return result
@@ -338,12 +660,26 @@ async def get_all_categories():
 # ----- Undo -----
 
 @api_router.post("/undo", response_model=dict)
-async def undo_last_action():
+def undo_last_action():
     """Undo the last action (using Stack - pop)."""
     result = call_cpp_engine("undo")
     return result
 
 
+# ----- Batch -----
+
+@api_router.post("/batch", response_model=dict)
+def run_batch(calls: List[EngineCall]):
+    """Run several engine commands in one request (e.g. importer, dashboard page)."""
+    payload = []
+    for call in calls:
+        item = {"command": call.command}
+        if call.params:
+            item["params"] = call.params
+        payload.append(item)
+    return {"results": call_cpp_engine_batch(payload)}
+
+
 # ----- DSA Info (for academic presentation) -----
 
 @api_router.get("/dsa-info")
@@ -0,0 +1,121 @@
+"""
+Helpers for running the C++ finance engine from the behaviour tests.
+The engine is built with backend/cpp/Makefile on first use, and every test
+gets a fresh temporary data directory.
+"""
+
+import json
+import os
+import shutil
+import subprocess
+import tempfile
+import unittest
+from pathlib import Path
+
+CPP_DIR = Path(__file__).resolve().parent.parent / "backend" / "cpp"
+ENGINE = CPP_DIR / ("finance_engine.exe" if os.name == "nt" else "finance_engine")
+
+# Seconds any single engine run may take before the test fails
+TIMEOUT = 60
+
+_built = False
+
+
+def build_engine():
+    """Bring the engine binary up to date once per test run."""
+    global _built
+    if not _built:
+        subprocess.run(["make", "-s", "-C", str(CPP_DIR), "finance_engine"],
+                       check=True, timeout=600)
+        _built = True
+
+
+def transaction(amount=25.0, category="Food", date="2024-03-15", kind="expense",
+                description="lunch"):
+    """Params of an add_transaction command."""
+    return {"type": kind, "amount": amount, "category": category,
+            "description": description, "date": date}
+
+
+def run_oneshot(data_dir, request, *args):
+    """Run one request through a one-shot engine; returns the CompletedProcess."""
+    return subprocess.run([str(ENGINE), str(data_dir), *args],
+                          input=json.dumps(request) + "\n", capture_output=True,
+                          text=True, timeout=TIMEOUT)
+
+
+class ResidentEngine:
+    """A `finance_engine <dataDir> --serve` process answering one line per request."""
+
+    def __init__(self, data_dir, *args):
+        self.proc = subprocess.Popen([str(ENGINE), str(data_dir), "--serve", *args],
+                                     stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     stderr=subprocess.PIPE, text=True, bufsize=1)
+
+    def send(self, request: dict) -> dict:
+        """Send one request envelope and parse the answer."""
+        self.proc.stdin.write(json.dumps(request) + "\n")
+        self.proc.stdin.flush()
+        line = self.proc.stdout.readline()
+        if not line:
+            raise AssertionError("engine exited: " + self.proc.stderr.read())
+        return json.loads(line)
+
+    def call(self, command: str, **params) -> dict:
+        request = {"command": command}
+        if params:
+            request["params"] = params
+        return self.send(request)
+
+    def send_lines(self, request: dict) -> list:
+        """Send a streamed request and collect its lines up to the trailer."""
+        self.proc.stdin.write(json.dumps(request) + "\n")
+        self.proc.stdin.flush()
+        lines = []
+        while True:
+            line = self.proc.stdout.readline()
+            if not line:
+                raise AssertionError("engine exited mid-stream")
+            lines.append(json.loads(line))
+            if "done" in lines[-1] or "error" in lines[-1]:
+                return lines
+
+    def close(self) -> int:
+        """Close stdin, which ends serve mode cleanly; returns the exit code."""
+        self.proc.stdin.close()
+        code = self.proc.wait(timeout=TIMEOUT)
+        self.proc.stdout.close()
+        self.proc.stderr.close()
+        return code
+
+    def kill(self):
+        """Stop the process without letting it finish anything (a crash)."""
+        self.proc.kill()
+        self.proc.wait(timeout=TIMEOUT)
+        self.proc.stdin.close()
+        self.proc.stdout.close()
+        self.proc.stderr.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        if self.proc.poll() is None:
+            self.close()
+
+
+class EngineTestCase(unittest.TestCase):
+    """Gives each test a temporary data directory at self.data_dir."""
+
+    @classmethod
+    def setUpClass(cls):
+        build_engine()
+
+    def setUp(self):
+        self.data_dir = Path(tempfile.mkdtemp(prefix="finance_test_"))
+        self.addCleanup(shutil.rmtree, self.data_dir, ignore_errors=True)
+
+    def serve(self, *args, data_dir=None) -> ResidentEngine:
+        engine = ResidentEngine(data_dir or self.data_dir, *args)
+        self.addCleanup(engine.__exit__)
+        return engine
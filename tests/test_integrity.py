@@ -0,0 +1,83 @@
+"""
+Checksummed files: damage fails the load with an error naming the file and
+leaves every file untouched, and --salvage-log recovers a damaged log.
+"""
+
+import json
+import shutil
+import tempfile
+import unittest
+from pathlib import Path
+
+from tests.engine_harness import EngineTestCase, run_oneshot, transaction
+
+
+def flip_byte(path: Path, offset: int):
+    data = bytearray(path.read_bytes())
+    data[offset] ^= 0xFF
+    path.write_bytes(bytes(data))
+
+
+class IntegrityTest(EngineTestCase):
+
+    def write_transactions(self, count, data_dir=None):
+        with self.serve(data_dir=data_dir) as engine:
+            for i in range(count):
+                engine.call("add_transaction", **transaction(amount=i + 1))
+
+    def file_contents(self):
+        return {path.name: path.read_bytes() for path in self.data_dir.iterdir()}
+
+    def assert_load_fails(self, file_name):
+        before = self.file_contents()
+        result = run_oneshot(self.data_dir, {"command": "get_dashboard"})
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn(file_name, result.stderr)
+        self.assertEqual(self.file_contents(), before)
+        return result.stderr
+
+    def test_damaged_snapshot_fails_the_load(self):
+        self.write_transactions(3)
+        snapshot = max(self.data_dir.glob("transactions-*.snap"))
+        flip_byte(snapshot, snapshot.stat().st_size // 2)
+        message = self.assert_load_fails(str(self.data_dir))
+        self.assertIn("backup", message)
+
+    def test_hole_in_the_log_fails_the_load(self):
+        self.write_transactions(6)
+        log = self.data_dir / "engine.wal"
+        flip_byte(log, log.stat().st_size // 2)
+        message = self.assert_load_fails("engine.wal")
+        self.assertIn("--salvage-log", message)
+        self.assertNotIn("--import-json", message)
+
+    def test_salvage_log_keeps_the_records_before_the_damage(self):
+        self.write_transactions(6)
+        log = self.data_dir / "engine.wal"
+        flip_byte(log, log.stat().st_size // 2)
+        damaged = log.read_bytes()
+
+        result = run_oneshot(self.data_dir, {"command": "get_dashboard"}, "--salvage-log")
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual((self.data_dir / "engine.wal.damaged").read_bytes(), damaged)
+        kept = run_oneshot(self.data_dir, {"command": "get_transactions"})
+        amounts = sorted(t["amount"] for t in json.loads(kept.stdout)["transactions"])
+        self.assertEqual(amounts, [1, 2, 3])
+
+    def test_damaged_tenant_fails_only_its_own_requests(self):
+        tenant_root = Path(tempfile.mkdtemp(prefix="finance_tenants_"))
+        self.addCleanup(shutil.rmtree, tenant_root, ignore_errors=True)
+        (tenant_root / "eve").mkdir()
+        self.write_transactions(6, data_dir=tenant_root / "eve")
+        log = tenant_root / "eve" / "engine.wal"
+        flip_byte(log, log.stat().st_size // 2)
+
+        with self.serve("--tenant-root", str(tenant_root)) as engine:
+            self.assertIn("error", engine.send({"tenant": "eve", "command": "get_dashboard"}))
+            self.assertIn("transactionCount",
+                          engine.send({"tenant": "frank", "command": "get_dashboard"}))
+            self.assertIn("transactionCount", engine.call("get_dashboard"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,121 @@
+"""
+Long reads run on a published version of the engine: a stream the client is
+slow to read neither blocks writers nor sees their changes.
+"""
+
+import json
+import os
+import socket
+import subprocess
+import time
+import unittest
+
+from tests.engine_harness import ENGINE, TIMEOUT, EngineTestCase, transaction
+
+
+class SocketClient:
+    """One connection to a `--socket` engine."""
+
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.settimeout(TIMEOUT)
+        self.sock.connect(path)
+        self.reader = self.sock.makefile("r")
+
+    def send(self, request: dict):
+        self.sock.sendall((json.dumps(request) + "\n").encode())
+
+    def call(self, request: dict) -> dict:
+        self.send(request)
+        return json.loads(self.reader.readline())
+
+    def close(self):
+        self.reader.close()
+        self.sock.close()
+
+
+@unittest.skipUnless(hasattr(socket, "AF_UNIX"), "needs Unix domain sockets")
+class SnapshotReadTest(EngineTestCase):
+
+    TRANSACTIONS = 20000  # a listing far larger than the socket buffers
+
+    def setUp(self):
+        super().setUp()
+        self.socket_path = str(self.data_dir / "engine.sock")
+        proc = subprocess.Popen([str(ENGINE), str(self.data_dir), "--socket", self.socket_path,
+                                 "--workers", "4"], stderr=subprocess.DEVNULL)
+        self.addCleanup(proc.wait, TIMEOUT)
+        self.addCleanup(proc.terminate)
+        deadline = time.monotonic() + TIMEOUT
+        while not os.path.exists(self.socket_path):
+            self.assertIsNone(proc.poll(), "engine exited")
+            self.assertLess(time.monotonic(), deadline)
+            time.sleep(0.01)
+
+    def client(self) -> SocketClient:
+        client = SocketClient(self.socket_path)
+        self.addCleanup(client.close)
+        return client
+
+    def fill(self, writer):
+        for start in range(0, self.TRANSACTIONS, 1000):
+            dates = [f"2023-{1 + i % 12:02d}-{1 + i % 28:02d}" for i in range(start, start + 1000)]
+            calls = [{"command": "add_transaction", "params": transaction(amount=1, date=date)}
+                     for date in dates]
+            self.assertEqual(len(writer.call({"batch": calls})["results"]), 1000)
+
+    def test_slow_stream_does_not_block_writers_or_see_their_changes(self):
+        writer, reader = self.client(), self.client()
+        self.fill(writer)
+
+        reader.send({"command": "get_transactions", "params": {"stream": True}})
+        self.assertIn("id", json.loads(reader.reader.readline()))
+
+        # The stream is stalled on the reader's full socket buffer
+        started = time.monotonic()
+        added = writer.call({"command": "add_transaction", "params": transaction(amount=500)})
+        self.assertTrue(added["success"])
+        self.assertLess(time.monotonic() - started, 5)
+        dashboard = writer.call({"command": "get_dashboard"})
+        self.assertEqual(dashboard["transactionCount"], self.TRANSACTIONS + 1)
+
+        lines = 1
+        while True:
+            record = json.loads(reader.reader.readline())
+            if "done" in record:
+                break
+            self.assertNotEqual(record["amount"], 500)
+            lines += 1
+        self.assertEqual(record["count"], self.TRANSACTIONS)
+        self.assertEqual(lines, self.TRANSACTIONS)
+
+    def test_reads_after_a_write_see_it(self):
+        writer = self.client()
+        writer.call({"command": "add_transaction", "params": transaction(amount=1)})
+        first = writer.call({"command": "get_monthly_summary", "params": {"month": "2024-03"}})
+        writer.call({"command": "add_transaction", "params": transaction(amount=2)})
+        second = writer.call({"command": "get_monthly_summary", "params": {"month": "2024-03"}})
+        self.assertEqual(first["summary"]["transactionCount"], 1)
+        self.assertEqual(second["summary"]["transactionCount"], 2)
+        self.assertEqual(len(writer.call({"command": "get_transactions"})["transactions"]), 2)
+
+    def test_published_versions_follow_every_kind_of_write(self):
+        # Each long read publishes a version; older ones are brought up to
+        # date by replaying the writes since, which must match the engine
+        writer = self.client()
+        for step in range(30):
+            params = transaction(amount=step + 1, date=f"2024-03-{1 + step % 28:02d}")
+            added = writer.call({"command": "add_transaction", "params": params})
+            if step % 3 == 1:
+                writer.call({"command": "delete_transaction",
+                             "params": {"id": added["transaction"]["id"]}})
+            if step % 5 == 4:
+                writer.call({"command": "undo"})
+            listing = writer.call({"command": "get_transactions"})["transactions"]
+            dashboard = writer.call({"command": "get_dashboard"})
+            self.assertEqual(len(listing), dashboard["transactionCount"], step)
+            self.assertAlmostEqual(sum(t["amount"] for t in listing), dashboard["totalExpenses"])
+
+
+if __name__ == "__main__":
+    unittest.main()
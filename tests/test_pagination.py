@@ -0,0 +1,71 @@
+"""
+Keyset cursor pagination of get_transactions and get_transactions_by_date.
+"""
+
+import unittest
+
+from tests.engine_harness import EngineTestCase, transaction
+
+
+class PaginationTest(EngineTestCase):
+
+    def add_days(self, engine, days, per_day=1):
+        for day in days:
+            for _ in range(per_day):
+                engine.call("add_transaction", **transaction(date=f"2024-01-{day:02d}"))
+
+    def collect(self, engine, command, limit, **params):
+        """Every page of a listing, following nextCursor to the end."""
+        pages = []
+        cursor = None
+        while True:
+            page_params = dict(params, limit=str(limit))
+            if cursor:
+                page_params["cursor"] = cursor
+            page = engine.call(command, **page_params)
+            pages.append(page["transactions"])
+            cursor = page["nextCursor"]
+            if cursor is None:
+                return pages
+
+    def test_pages_cover_every_transaction_once_newest_first(self):
+        with self.serve() as engine:
+            self.add_days(engine, range(1, 11), per_day=2)  # dates arrive in order
+            everything = engine.call("get_transactions")["transactions"]
+            pages = self.collect(engine, "get_transactions", 3)
+
+        self.assertEqual([len(page) for page in pages], [3, 3, 3, 3, 3, 3, 2])
+        paged = [t for page in pages for t in page]
+        self.assertEqual([t["id"] for t in paged], [t["id"] for t in everything])
+        dates = [t["date"] for t in paged]
+        self.assertEqual(dates, sorted(dates, reverse=True))
+
+    def test_date_range_pages_ascend_within_the_range(self):
+        with self.serve() as engine:
+            self.add_days(engine, [5, 1, 9, 3, 7, 2, 8])
+            pages = self.collect(engine, "get_transactions_by_date", 2,
+                                 startDate="2024-01-02", endDate="2024-01-08")
+        dates = [t["date"][-2:] for page in pages for t in page]
+        self.assertEqual(dates, ["02", "03", "05", "07", "08"])
+
+    def test_cursor_is_stable_across_inserts(self):
+        with self.serve() as engine:
+            self.add_days(engine, range(1, 7))
+            first = engine.call("get_transactions", limit="3")
+            # Newer than the cursor: belongs to a page already read
+            engine.call("add_transaction", **transaction(date="2024-02-01"))
+            rest = engine.call("get_transactions", limit="10", cursor=first["nextCursor"])
+
+        self.assertEqual([t["date"][-2:] for t in rest["transactions"]], ["03", "02", "01"])
+        self.assertIsNone(rest["nextCursor"])
+
+    def test_without_limit_the_whole_listing_has_no_cursor(self):
+        with self.serve() as engine:
+            self.add_days(engine, range(1, 4))
+            listing = engine.call("get_transactions")
+        self.assertEqual(len(listing["transactions"]), 3)
+        self.assertNotIn("nextCursor", listing)
+
+
+if __name__ == "__main__":
+    unittest.main()
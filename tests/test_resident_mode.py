@@ -0,0 +1,59 @@
+"""
+Resident --serve mode: one process answers many requests from memory.
+"""
+
+import unittest
+
+from tests.engine_harness import EngineTestCase, run_oneshot, transaction
+
+
+class ResidentModeTest(EngineTestCase):
+
+    def test_answers_every_line_from_the_same_state(self):
+        with self.serve() as engine:
+            added = engine.call("add_transaction", **transaction(amount=40))
+            self.assertTrue(added["success"])
+            engine.call("add_transaction", **transaction(amount=2.5, category="Coffee"))
+            dashboard = engine.call("get_dashboard")
+            self.assertEqual(dashboard["transactionCount"], 2)
+            self.assertAlmostEqual(dashboard["totalExpenses"], 42.5)
+
+    def test_changes_outlive_the_process(self):
+        with self.serve() as engine:
+            engine.call("set_budget", category="Food", limit=300)
+            engine.call("add_transaction", **transaction(amount=60))
+            self.assertEqual(engine.close(), 0)
+
+        result = run_oneshot(self.data_dir, {"command": "get_budgets"})
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn('"spent":60', result.stdout)
+
+    def test_unknown_command_does_not_end_the_session(self):
+        with self.serve() as engine:
+            self.assertIn("error", engine.call("no_such_command"))
+            self.assertEqual(engine.call("get_dashboard")["transactionCount"], 0)
+
+    def test_recent_list_drops_deleted_and_undone_transactions(self):
+        with self.serve() as engine:
+            first = engine.call("add_transaction", **transaction(description="first"))
+            engine.call("add_transaction", **transaction(description="second"))
+            engine.call("add_transaction", **transaction(description="third"))
+
+            engine.call("delete_transaction", id=first["transaction"]["id"])
+            engine.call("undo")  # the delete: "first" is back
+            engine.call("undo")  # adding "third"
+
+            recent = engine.call("get_recent_transactions", count="10")["transactions"]
+            self.assertEqual(sorted(t["description"] for t in recent), ["first", "second"])
+
+    def test_list_commands_reports_access_modes(self):
+        with self.serve() as engine:
+            commands = {c["name"]: c["access"] for c in engine.call("list_commands")["commands"]}
+        self.assertEqual(commands["add_transaction"], "write")
+        self.assertEqual(commands["undo"], "write")
+        self.assertEqual(commands["get_dashboard"], "read")
+        self.assertEqual(commands["list_commands"], "read")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,94 @@
+"""
+backend/server.py's handling of the resident engine: deadlines, restarts and
+which requests it resends. Fake engines are small shell scripts, so these
+tests need a POSIX shell as well as the server's own dependencies.
+"""
+
+import importlib.util
+import os
+import stat
+import sys
+import tempfile
+import time
+import unittest
+from pathlib import Path
+
+from tests.engine_harness import build_engine
+
+BACKEND_DIR = Path(__file__).resolve().parent.parent / "backend"
+HAVE_SERVER_DEPS = all(importlib.util.find_spec(name) for name in ("fastapi", "dotenv"))
+
+
+def fake_engine(directory: Path, body: str) -> Path:
+    """A shell script standing in for finance_engine."""
+    path = directory / "fake_engine.sh"
+    path.write_text("#!/bin/sh\n" + body)
+    path.chmod(path.stat().st_mode | stat.S_IXUSR)
+    return path
+
+
+@unittest.skipUnless(HAVE_SERVER_DEPS and os.name == "posix", "needs fastapi, dotenv and sh")
+class ResidentEngineTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        build_engine()
+        sys.path.insert(0, str(BACKEND_DIR))
+        import server
+        cls.server = server
+
+    def setUp(self):
+        self.scratch = Path(tempfile.mkdtemp(prefix="finance_server_test_"))
+        self.saved = (self.server.CPP_ENGINE, self.server.DATA_DIR,
+                      self.server.ENGINE_TIMEOUT, self.server._read_only_commands)
+        # The one-shot engine finds its data at ../data, as under backend/data
+        self.server.DATA_DIR = self.scratch / "data"
+        self.server.DATA_DIR.mkdir()
+        self.engine = self.server.ResidentEngine()
+
+    def tearDown(self):
+        self.engine._stop()
+        (self.server.CPP_ENGINE, self.server.DATA_DIR,
+         self.server.ENGINE_TIMEOUT, self.server._read_only_commands) = self.saved
+
+    def test_real_engine_round_trip(self):
+        output = self.engine.request('{"command":"get_dashboard"}', {"command": "get_dashboard"})
+        self.assertIn('"transactionCount":0', output)
+
+    def test_read_only_commands_come_from_the_engine(self):
+        read_only = self.server.read_only_commands()
+        self.assertIn("get_transactions", read_only)
+        self.assertNotIn("add_transaction", read_only)
+        self.assertTrue(self.server.is_read_only(
+            {"batch": [{"command": "get_bills"}, {"command": "get_dashboard"}]}))
+        self.assertFalse(self.server.is_read_only(
+            {"batch": [{"command": "get_bills"}, {"command": "pay_bill"}]}))
+
+    def test_hung_engine_times_out_and_is_replaced(self):
+        self.server.CPP_ENGINE = fake_engine(self.scratch, "exec sleep 60\n")
+        self.server.ENGINE_TIMEOUT = 0.5
+        started = time.monotonic()
+        with self.assertRaises(self.server.subprocess.TimeoutExpired):
+            self.engine.request('{"command":"get_dashboard"}', {"command": "get_dashboard"})
+        self.assertLess(time.monotonic() - started, 5)
+        self.assertIsNone(self.engine._proc)
+
+    def test_write_is_not_resent_after_the_engine_dies(self):
+        # Counts the lines it was sent, then exits without answering
+        self.server.CPP_ENGINE = fake_engine(
+            self.scratch, 'read line; echo "$line" >> "$(dirname "$0")/seen"; exit 1\n')
+        self.server._read_only_commands = frozenset({"get_dashboard"})
+        with self.assertRaises(self.server.EngineUnavailable):
+            self.engine.request('{"command":"add_bill"}', {"command": "add_bill"})
+        self.assertEqual(len((self.scratch / "seen").read_text().splitlines()), 1)
+
+    def test_read_is_resent_once_after_the_engine_dies(self):
+        self.server.CPP_ENGINE = fake_engine(
+            self.scratch, 'read line; echo "$line" >> "$(dirname "$0")/seen"; exit 1\n')
+        self.server._read_only_commands = frozenset({"get_dashboard"})
+        self.engine.request('{"command":"get_dashboard"}', {"command": "get_dashboard"})
+        self.assertEqual(len((self.scratch / "seen").read_text().splitlines()), 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,86 @@
+"""
+backend/server.py's NDJSON streams: chunks pass through as the engine writes
+them, the engine is released without waiting for the client, and a stream
+the engine does not finish ends with an error line.
+"""
+
+import json
+import os
+import sys
+import tempfile
+import time
+import unittest
+from pathlib import Path
+
+from tests.engine_harness import build_engine, transaction
+from tests.test_server import BACKEND_DIR, HAVE_SERVER_DEPS, fake_engine
+
+STREAM_ALL = {"command": "get_transactions", "params": {"stream": True}}
+
+
+@unittest.skipUnless(HAVE_SERVER_DEPS and os.name == "posix", "needs fastapi, dotenv and sh")
+class StreamTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        build_engine()
+        sys.path.insert(0, str(BACKEND_DIR))
+        import server
+        cls.server = server
+
+    def setUp(self):
+        self.scratch = Path(tempfile.mkdtemp(prefix="finance_stream_test_"))
+        self.saved = (self.server.CPP_ENGINE, self.server.DATA_DIR, self.server.ENGINE_TIMEOUT)
+        self.server.DATA_DIR = self.scratch / "data"
+        self.server.DATA_DIR.mkdir()
+        self.engine = self.server.ResidentEngine()
+
+    def tearDown(self):
+        self.engine._stop()
+        self.server.CPP_ENGINE, self.server.DATA_DIR, self.server.ENGINE_TIMEOUT = self.saved
+
+    def stream_lines(self, request: dict) -> list:
+        body = b"".join(self.engine.stream(json.dumps(request)))
+        return [json.loads(line) for line in body.decode().splitlines()]
+
+    def test_streams_every_transaction_and_the_trailer(self):
+        for amount in (10, 20, 30):
+            add = {"command": "add_transaction", "params": transaction(amount=amount)}
+            self.engine.request(json.dumps(add), add)
+        lines = self.stream_lines(STREAM_ALL)
+        self.assertEqual(sorted(line["amount"] for line in lines[:-1]), [10, 20, 30])
+        self.assertEqual(lines[-1], {"done": True, "count": 3})
+
+    def test_engine_is_released_before_the_client_reads(self):
+        for _ in range(50):
+            add = {"command": "add_transaction", "params": transaction()}
+            self.engine.request(json.dumps(add), add)
+        chunks = self.engine.stream(json.dumps(STREAM_ALL))
+        next(chunks)
+        deadline = time.monotonic() + 10
+        while self.engine._lock.locked() and time.monotonic() < deadline:
+            time.sleep(0.01)
+        self.assertFalse(self.engine._lock.locked())
+        dashboard = self.engine.request('{"command":"get_dashboard"}', {"command": "get_dashboard"})
+        self.assertIn('"transactionCount":50', dashboard)
+        chunks.close()
+
+    def test_engine_exit_mid_stream_ends_with_an_error_line(self):
+        self.server.CPP_ENGINE = fake_engine(
+            self.scratch, "read line; echo '{\"id\":\"a\"}'; exit 1\n")
+        lines = self.stream_lines(STREAM_ALL)
+        self.assertEqual(lines[0], {"id": "a"})
+        self.assertIn("error", lines[-1])
+        self.assertFalse(self.engine._lock.locked())
+
+    def test_stalled_stream_times_out_with_an_error_line(self):
+        self.server.CPP_ENGINE = fake_engine(
+            self.scratch, "read line; echo '{\"id\":\"a\"}'; exec sleep 60\n")
+        self.server.ENGINE_TIMEOUT = 0.5
+        lines = self.stream_lines(STREAM_ALL)
+        self.assertEqual(lines, [{"id": "a"}, {"error": "Engine timeout"}])
+        self.assertIsNone(self.engine._proc)
+
+
+if __name__ == "__main__":
+    unittest.main()
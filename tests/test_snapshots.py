@@ -0,0 +1,86 @@
+"""
+Binary snapshots: the state reloads from them, the JSON files are only read
+on the first run or with --import-json, and a failed import changes nothing.
+"""
+
+import json
+import unittest
+
+from tests.engine_harness import EngineTestCase, run_oneshot, transaction
+
+
+class SnapshotTest(EngineTestCase):
+
+    def write_json_files(self, transactions=(), budgets=(), bills=()):
+        for name, records in (("transactions", transactions), ("budgets", budgets),
+                              ("bills", bills), ("undo_stack", ())):
+            key = "actions" if name == "undo_stack" else name
+            (self.data_dir / f"{name}.json").write_text(json.dumps({key: list(records)}))
+
+    def dashboard(self):
+        result = run_oneshot(self.data_dir, {"command": "get_dashboard"})
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return json.loads(result.stdout)
+
+    def test_state_reloads_from_snapshots(self):
+        with self.serve() as engine:
+            engine.call("add_transaction", **transaction(amount=12))
+            engine.call("add_bill", name="Rent", amount=900, dueDate="2024-04-01",
+                        category="Housing")
+            engine.call("set_budget", category="Food", limit=250)
+        self.assertTrue((self.data_dir / "snapshot.manifest").exists())
+        self.assertFalse((self.data_dir / "transactions.json").exists())
+
+        dashboard = self.dashboard()
+        self.assertEqual((dashboard["transactionCount"], dashboard["billCount"],
+                          dashboard["budgetCount"]), (1, 1, 1))
+
+    def test_first_run_imports_the_json_files(self):
+        self.write_json_files(
+            transactions=[dict(id="txn_1_1", **transaction(amount=7))],
+            budgets=[{"category": "Food", "limit": 100}])
+        dashboard = self.dashboard()
+        self.assertEqual(dashboard["transactionCount"], 1)
+        self.assertEqual(dashboard["budgetCount"], 1)
+        self.assertTrue((self.data_dir / "snapshot.manifest").exists())
+
+        # Later runs read the snapshots, not the JSON files
+        self.write_json_files()
+        self.assertEqual(self.dashboard()["transactionCount"], 1)
+
+    def test_export_and_import_round_trip(self):
+        with self.serve() as engine:
+            engine.call("add_transaction", **transaction(amount=3, category="Coffee"))
+            engine.call("add_transaction",
+                        **transaction(amount=5000, kind="income", category="Salary"))
+        self.assertEqual(run_oneshot(self.data_dir, {}, "--export-json").returncode, 0)
+        before = self.dashboard()
+
+        with self.serve() as engine:
+            engine.call("add_transaction", **transaction(amount=99))
+        self.assertEqual(run_oneshot(self.data_dir, {}, "--import-json").returncode, 0)
+        self.assertEqual(self.dashboard(), before)
+
+    def test_failed_import_keeps_the_previous_checkpoint_and_log(self):
+        self.write_json_files()
+        with self.serve() as engine:
+            engine.call("add_transaction", **transaction(amount=11))
+            engine.call("add_transaction", **transaction(amount=22))
+        before = self.dashboard()
+        files = {path.name: path.read_bytes() for path in self.data_dir.iterdir()}
+
+        # A directory where the new manifest's temporary file should go makes
+        # the import's checkpoint fail
+        blocker = self.data_dir / "snapshot.manifest.tmp"
+        blocker.mkdir()
+        result = run_oneshot(self.data_dir, {}, "--import-json")
+        self.assertNotEqual(result.returncode, 0)
+        blocker.rmdir()
+
+        for name, data in files.items():
+            self.assertEqual((self.data_dir / name).read_bytes(), data, name)
+        self.assertEqual(self.dashboard(), before)
+
+
+if __name__ == "__main__":
+    unittest.main()
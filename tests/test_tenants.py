@@ -0,0 +1,81 @@
+"""
+Many tenants in one resident process (--tenant-root): isolation, lazy
+directories, and eviction under --memory-budget.
+"""
+
+import shutil
+import tempfile
+import unittest
+from pathlib import Path
+
+from tests.engine_harness import EngineTestCase, transaction
+
+
+class TenantTest(EngineTestCase):
+
+    def setUp(self):
+        super().setUp()
+        self.tenant_root = Path(tempfile.mkdtemp(prefix="finance_tenants_"))
+        self.addCleanup(shutil.rmtree, self.tenant_root, ignore_errors=True)
+
+    def serve_tenants(self, *args):
+        return self.serve("--tenant-root", str(self.tenant_root), *args)
+
+    @staticmethod
+    def call(engine, tenant, command, **params):
+        request = {"tenant": tenant, "command": command}
+        if params:
+            request["params"] = params
+        return engine.send(request)
+
+    def test_tenants_see_only_their_own_data(self):
+        with self.serve_tenants() as engine:
+            self.call(engine, "alice", "add_transaction", **transaction(amount=10))
+            self.call(engine, "bob", "set_budget", category="Food", limit=50)
+            alice = self.call(engine, "alice", "get_dashboard")
+            bob = self.call(engine, "bob", "get_dashboard")
+            default = engine.call("get_dashboard")
+        self.assertEqual((alice["transactionCount"], alice["budgetCount"]), (1, 0))
+        self.assertEqual((bob["transactionCount"], bob["budgetCount"]), (0, 1))
+        self.assertEqual(default["transactionCount"], 0)
+
+    def test_directory_is_created_by_the_first_write(self):
+        with self.serve_tenants() as engine:
+            self.call(engine, "carol", "get_dashboard")
+            self.call(engine, "carol", "get_bills")
+            self.assertFalse((self.tenant_root / "carol").exists())
+            self.call(engine, "carol", "add_transaction", **transaction())
+            self.assertTrue((self.tenant_root / "carol").is_dir())
+
+    def test_invalid_tenant_names_are_rejected(self):
+        with self.serve_tenants() as engine:
+            for name in ("../escape", "a/b", ""):
+                self.assertIn("error", self.call(engine, name, "get_dashboard"), name)
+        self.assertEqual(list(self.tenant_root.iterdir()), [])
+
+    def test_evicted_tenants_reload_and_never_reuse_an_id(self):
+        # With no budget every other tenant is evicted after each request
+        with self.serve_tenants("--memory-budget", "0") as engine:
+            ids = []
+            for _ in range(3):
+                for tenant in ("alice", "bob"):
+                    added = self.call(engine, tenant, "add_transaction", **transaction())
+                    ids.append((tenant, added["transaction"]["id"]))
+            alice = self.call(engine, "alice", "get_transactions")["transactions"]
+
+        self.assertEqual(len(alice), 3)
+        self.assertEqual(len(set(t["id"] for t in alice)), 3)
+        alice_ids = [i for tenant, i in ids if tenant == "alice"]
+        self.assertEqual(sorted(t["id"] for t in alice), sorted(alice_ids))
+
+    def test_tenant_data_outlives_the_process(self):
+        with self.serve_tenants() as engine:
+            self.call(engine, "dave", "add_bill", name="Gym", amount=30,
+                      dueDate="2024-05-01", category="Health")
+        with self.serve_tenants() as engine:
+            bills = self.call(engine, "dave", "get_bills")["bills"]
+        self.assertEqual([b["name"] for b in bills], ["Gym"])
+
+
+if __name__ == "__main__":
+    unittest.main()
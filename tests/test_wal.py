@@ -0,0 +1,63 @@
+"""
+The write-ahead log: acknowledged writes survive a crash, and a torn record
+at the end of the log (a write cut short by the crash) is trimmed.
+"""
+
+import random
+import time
+import unittest
+
+from tests.engine_harness import EngineTestCase, run_oneshot, transaction
+
+
+class WalTest(EngineTestCase):
+
+    def dashboard_line(self):
+        result = run_oneshot(self.data_dir, {"command": "get_dashboard"})
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return result.stdout
+
+    def crash_after_writes(self, count):
+        engine = self.serve()
+        for i in range(count):
+            self.assertTrue(engine.call("add_transaction", **transaction(amount=i + 1))["success"])
+        engine.kill()
+
+    def test_acknowledged_writes_survive_a_crash(self):
+        self.crash_after_writes(5)
+        self.assertIn('"transactionCount":5', self.dashboard_line())
+
+    def test_writes_append_to_the_log_between_checkpoints(self):
+        self.crash_after_writes(1)
+        manifest = (self.data_dir / "snapshot.manifest").read_bytes()
+        log_size = (self.data_dir / "engine.wal").stat().st_size
+
+        self.crash_after_writes(3)
+        self.assertEqual((self.data_dir / "snapshot.manifest").read_bytes(), manifest)
+        self.assertGreater((self.data_dir / "engine.wal").stat().st_size, log_size)
+
+    def test_torn_tail_is_trimmed(self):
+        self.crash_after_writes(3)
+        log = self.data_dir / "engine.wal"
+        intact = log.read_bytes()
+        log.write_bytes(intact + intact[:len(intact) // 6])  # a record cut short
+
+        with self.serve() as engine:
+            self.assertEqual(engine.call("get_dashboard")["transactionCount"], 3)
+            engine.call("add_transaction", **transaction(amount=4))
+        self.assertTrue(log.read_bytes().startswith(intact))
+        self.assertIn('"transactionCount":4', self.dashboard_line())
+
+    def test_large_garbage_tail_loads_quickly(self):
+        self.crash_after_writes(2)
+        log = self.data_dir / "engine.wal"
+        garbage = random.Random(4).randbytes(1 << 20)
+        log.write_bytes(log.read_bytes() + garbage)
+
+        started = time.monotonic()
+        self.assertIn('"transactionCount":2', self.dashboard_line())
+        self.assertLess(time.monotonic() - started, 10)
+
+
+if __name__ == "__main__":
+    unittest.main()